@@ -10,6 +10,11 @@ void all_k_inputs_functions( Exp&& exp, uint32_t num_vars )
   using network_type = tweedledum::netlist<tweedledum::mcmt_gate>;
   network_type network;
 
+  /* one manager for all functions, collect the nodes of earlier functions every 1024 functions */
+  angel::qsp_bdd_engine_params ps;
+  ps.batch_size = 1024u;
+  angel::qsp_bdd_engine engine( ps );
+
   kitty::dynamic_truth_table tt( num_vars );
   /* TODO: implementation does not work for 0 */
   kitty::next_inplace( tt );
@@ -19,7 +24,7 @@ void all_k_inputs_functions( Exp&& exp, uint32_t num_vars )
     std::string tt_str = kitty::to_binary( tt );
     std::reverse(tt_str.begin(), tt_str.end());
     angel::qsp_bdd_statistics stats;
-    angel::qsp_bdd<network_type>( network, tt_str, stats );
+    engine( network, tt_str, stats );
     //stats.report();
     exp( fmt::format( "func {}", i ), stats.nodes, stats.cnots, stats.sqgs , stats.MC_gates );
     //if(i == 100)
@@ -43,8 +48,12 @@ int main()
   network_type network;
   std::string tt_str = "11101000";
   //std::reverse(tt_str.begin(), tt_str.end());
+  /* also write the BDD to graph.dot */
+  angel::qsp_bdd_engine_params ps;
+  ps.dump_bdd = true;
+  angel::qsp_bdd_engine engine( ps );
   angel::qsp_bdd_statistics stats;
-  angel::qsp_bdd<network_type>( network, tt_str, stats );
+  engine( network, tt_str, stats );
   stats.report();
 
   return 0;
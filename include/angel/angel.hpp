@@ -1,12 +1,19 @@
 #include <angel/dependency_analysis/common.hpp>
 #include <angel/dependency_analysis/pattern_based_dependency_analysis.hpp>
+#include <angel/dependency_analysis/sat_based_dependency_analysis.hpp>
 #include <angel/dependency_analysis/esop_based_dependency_analysis.hpp>
+#include <angel/dependency_analysis/bdd_based_dependency_analysis.hpp>
+#include <angel/dependency_analysis/cascade_dependency_analysis.hpp>
 #include <angel/dependency_analysis/no_deps.hpp>
 #include <angel/quantum_state_preparation/qsp_deps.hpp>
 #include <angel/quantum_state_preparation/qsp_bdd.hpp>
+#include <angel/reordering/common.hpp>
 #include <angel/reordering/exhaustive_reordering.hpp>
 #include <angel/reordering/greedy_reordering.hpp>
 #include <angel/reordering/no_reordering.hpp>
 #include <angel/reordering/random_reordering.hpp>
+#include <angel/utils/bdd_from_truth_table.hpp>
+#include <angel/utils/column_matrix.hpp>
 #include <angel/utils/function_extractor.hpp>
+#include <angel/utils/lru_cache.hpp>
 #include <angel/utils/stopwatch.hpp>
@@ -0,0 +1,465 @@
+/* angel: C++ state preparation library
+ * Copyright (C) 2019-2020  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file bdd_based_dependency_analysis.hpp
+
+  \brief Pattern-based dependency analysis on the BDD of the on-set
+*/
+
+#pragma once
+
+#include "../quantum_state_preparation/utils.hpp"
+#include "../utils/bdd_from_truth_table.hpp"
+#include "../utils/stopwatch.hpp"
+#include "common.hpp"
+#include "pattern_based_dependency_analysis.hpp"
+
+#include <cplusplus/cuddObj.hh>
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/partial_truth_table.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+namespace angel
+{
+
+struct bdd_deps_analysis_params
+{
+  /* Maximum number of fanins of a pattern. */
+  uint32_t max_pattern_size{5};
+
+  /* Discard patterns that need more CNOTs than preparing the target without dependencies (see `compute_upperbound_cost`). */
+  bool use_upperbound = false;
+
+  /* Maximum number of variable sets checked per target (0 means no limit). */
+  uint64_t max_checked_sets{100000};
+
+  /* Be verbose. */
+  bool verbose = false;
+}; /* bdd_deps_analysis_params */
+
+struct bdd_deps_analysis_stats
+{
+  stopwatch<>::duration_type total_time{0};
+  stopwatch<>::duration_type construction_time{0};
+
+  /* number of targets that are a function of the variables with larger indices */
+  uint32_t num_determined_targets{0};
+
+  /* number of patterns return as result */
+  uint32_t num_patterns{0};
+
+  /* number of variable sets checked for a pattern */
+  uint64_t num_checked_sets{0};
+
+  /* number of targets whose search stopped at `max_checked_sets` */
+  uint32_t num_exhausted_budgets{0};
+
+  void report() const
+  {
+    fmt::print( "[i] total analysis time =  {:8.2f}s\n", to_seconds( total_time ) );
+    fmt::print( "[i]   BDD construction =   {:8.2f}s\n", to_seconds( construction_time ) );
+    fmt::print( "[i] computed patterns: {:8d} / {:8d} determined targets\n", num_patterns, num_determined_targets );
+    fmt::print( "[i] checked variable sets: {} ({} targets out of budget)\n", num_checked_sets, num_exhausted_budgets );
+  }
+
+  void reset()
+  {
+    *this = {};
+  }
+}; /* bdd_deps_analysis_stats */
+
+/*! \brief Pattern-based dependency analysis on BDDs
+
+  Finds the same EQUAL, XOR, XNOR, AND, and NAND patterns as
+  `pattern_deps_analysis`, but works on the BDD of the on-set instead of
+  its column vectors, such that functions with too many minterms for
+  explicit columns can be analysed.
+
+  For target `i`, the variables `0, ..., i-1` are existentially
+  quantified and the projection is split into the minterms with `x_i = 1`
+  and `x_i = 0`.  The target has a dependency only if both parts are
+  disjoint.  A variable is required if quantifying it makes both parts
+  intersect, every pattern contains all required variables.  The
+  remaining variables are added in increasing number until no cheaper
+  pattern can be found, and each candidate set is checked with BDD
+  implications.
+
+  Variable `i` of the function is the BDD variable with index `i`.
+*/
+class bdd_deps_analysis
+{
+public:
+  using parameter_type = bdd_deps_analysis_params;
+  using statistics_type = bdd_deps_analysis_stats;
+  using result_type = pattern_deps_analysis_result_type;
+
+public:
+  using function_type = kitty::dynamic_truth_table;
+
+public:
+  explicit bdd_deps_analysis( bdd_deps_analysis_params const& ps, bdd_deps_analysis_stats& st )
+      : ps( ps ), st( st )
+  {
+  }
+
+  pattern_deps_analysis_result_type run( function_type const& function )
+  {
+    std::vector<uint32_t> targets( function.num_vars() );
+    std::iota( std::begin( targets ), std::end( targets ), 0u );
+    return run( function, {}, targets );
+  }
+
+  /*! \brief Runs the analysis on the truth table, the column vectors are not used */
+  pattern_deps_analysis_result_type run( function_type const& function, std::vector<kitty::partial_truth_table> const& column_matrix )
+  {
+    (void)column_matrix;
+    return run( function );
+  }
+
+  /*! \brief Runs the analysis for some target variables only, the column vectors are not used */
+  pattern_deps_analysis_result_type run( function_type const& function, std::vector<kitty::partial_truth_table> const& column_matrix, std::vector<uint32_t> const& targets )
+  {
+    (void)column_matrix;
+    auto const onset = create_onset( function );
+    return analyse( manager, onset, function.num_vars(), targets, ps.use_upperbound );
+  }
+
+  /*! \brief Runs the analysis for some target variables only
+
+    Calls with the same prepared columns share the BDD, the columns are
+    not used otherwise.  `use_upperbound` is used instead of the
+    parameter of the same name.
+  */
+  pattern_deps_analysis_result_type run( function_type const& function, function_columns const& prepared, std::vector<uint32_t> const& targets, bool use_upperbound )
+  {
+    if ( onset_id != prepared.id )
+    {
+      function_onset = create_onset( function );
+      onset_id = prepared.id;
+    }
+    return analyse( manager, function_onset, function.num_vars(), targets, use_upperbound );
+  }
+
+  /*! \brief Runs the analysis on the BDD of the on-set of a function with `num_vars` variables */
+  pattern_deps_analysis_result_type run( Cudd const& cudd, BDD const& onset, uint32_t num_vars )
+  {
+    std::vector<uint32_t> targets( num_vars );
+    std::iota( std::begin( targets ), std::end( targets ), 0u );
+    return run( cudd, onset, num_vars, targets );
+  }
+
+  /*! \brief Runs the analysis on a BDD for some target variables only */
+  pattern_deps_analysis_result_type run( Cudd const& cudd, BDD const& onset, uint32_t num_vars, std::vector<uint32_t> const& targets )
+  {
+    return analyse( cudd, onset, num_vars, targets, ps.use_upperbound );
+  }
+
+private:
+  /*! \brief Creates the BDD of the on-set, variable `i` of the function is the BDD variable with index `i`
+
+    New variables are created at the top of the order, such that the
+    construction from the truth table is linear (see
+    `create_bdd_from_truth_table`).
+  */
+  BDD create_onset( function_type const& function )
+  {
+    uint32_t const num_vars = function.num_vars();
+    while ( static_cast<uint32_t>( manager.ReadSize() ) < num_vars )
+    {
+      manager.bddNewVarAtLevel( 0 );
+    }
+
+    std::vector<BDD> vars;
+    for ( auto i = 0u; i < num_vars; ++i )
+    {
+      vars.emplace_back( manager.bddVar( i ) );
+    }
+    return call_with_stopwatch( st.construction_time, [&]() {
+      return create_bdd_from_truth_table( manager, function, vars );
+    } );
+  }
+
+  /*! \brief Computes the dependencies of `targets` from the on-set, pruned by the upper bound if `use_upperbound` */
+  pattern_deps_analysis_result_type analyse( Cudd const& cudd, BDD const& onset, uint32_t num_vars, std::vector<uint32_t> targets, bool use_upperbound )
+  {
+    stopwatch t( st.total_time );
+
+    std::vector<BDD> vars;
+    for ( auto i = 0u; i < num_vars; ++i )
+    {
+      vars.emplace_back( cudd.bddVar( i ) );
+    }
+
+    std::vector<uint32_t> zero_lines, one_lines;
+    for ( auto i = 0u; i < num_vars; ++i )
+    {
+      if ( onset.Leq( !vars[i] ) )
+      {
+        zero_lines.emplace_back( i );
+      }
+      else if ( onset.Leq( vars[i] ) )
+      {
+        one_lines.emplace_back( i );
+      }
+    }
+
+    /* the projections are computed incrementally in increasing target order */
+    std::sort( std::begin( targets ), std::end( targets ) );
+
+    pattern_deps_analysis_result_type result;
+    BDD projection = onset;
+    uint32_t num_projected = 0u;
+    for ( auto const i : targets )
+    {
+      while ( num_projected < i )
+      {
+        projection = projection.ExistAbstract( vars[num_projected++] );
+      }
+
+      /* skip constants */
+      if ( std::find( std::begin( zero_lines ), std::end( zero_lines ), i ) != std::end( zero_lines ) )
+      {
+        result.dependencies[i] = std::make_pair( dependency_analysis_types::pattern_kind::CONST, std::vector<uint32_t>{ 0 } );
+        continue;
+      }
+      if ( std::find( std::begin( one_lines ), std::end( one_lines ), i ) != std::end( one_lines ) )
+      {
+        result.dependencies[i] = std::make_pair( dependency_analysis_types::pattern_kind::CONST, std::vector<uint32_t>{ 1 } );
+        continue;
+      }
+
+      BDD const on = projection.Cofactor( vars[i] );
+      BDD const off = projection.Cofactor( !vars[i] );
+      if ( !on.Leq( !off ) )
+      {
+        continue;
+      }
+      ++st.num_determined_targets;
+
+      auto upper_bound = std::numeric_limits<uint32_t>::max();
+      if ( use_upperbound && num_vars - i - 1u < 32u )
+      {
+        upper_bound = compute_upperbound_cost( zero_lines, one_lines, num_vars, i );
+      }
+
+      if ( auto const p = find_pattern( cudd, vars, on, off, upper_bound ) )
+      {
+        result.dependencies[i] = *p;
+        ++st.num_patterns;
+      }
+    }
+
+    return result;
+  }
+
+  /*! \brief Returns the cheapest pattern `p` with `on <= p` and `off <= !p` */
+  std::optional<dependency_analysis_types::pattern> find_pattern( Cudd const& cudd, std::vector<BDD> const& vars, BDD const& on, BDD const& off, uint32_t upper_bound )
+  {
+    best.reset();
+    this->upper_bound = upper_bound;
+
+    std::vector<uint32_t> required, optional;
+    for ( auto const j : cudd.SupportIndices( {on, off} ) )
+    {
+      if ( on.ExistAbstract( vars[j] ).Leq( !off.ExistAbstract( vars[j] ) ) )
+      {
+        optional.emplace_back( j );
+      }
+      else
+      {
+        required.emplace_back( j );
+      }
+    }
+    if ( required.size() > ps.max_pattern_size )
+    {
+      return std::nullopt;
+    }
+
+    uint64_t num_checked_sets = 0u;
+    std::vector<uint32_t> extra;
+    for ( auto size = std::max<uint32_t>( required.size(), 1u ); size <= ps.max_pattern_size; ++size )
+    {
+      /* a pattern with `size` fanins needs at least `size` CNOTs, an XOR of equal cost may save NOTs */
+      if ( size > upper_bound || ( best && best_cost.first < size ) )
+      {
+        break;
+      }
+
+      uint32_t const num_extra = size - required.size();
+      if ( num_extra > optional.size() )
+      {
+        break;
+      }
+
+      /* enumerate the subsets of `num_extra` optional variables */
+      extra.resize( num_extra );
+      std::iota( std::begin( extra ), std::end( extra ), 0u );
+      while ( true )
+      {
+        if ( ps.max_checked_sets != 0u && num_checked_sets == ps.max_checked_sets )
+        {
+          ++st.num_exhausted_budgets;
+          return best;
+        }
+        ++num_checked_sets;
+        ++st.num_checked_sets;
+
+        std::vector<uint32_t> support = required;
+        for ( auto const k : extra )
+        {
+          support.emplace_back( optional[k] );
+        }
+        std::sort( std::begin( support ), std::end( support ) );
+        check_patterns( cudd, vars, on, off, support );
+
+        /* next subset in lexicographic order */
+        int32_t k = int32_t( num_extra ) - 1;
+        while ( k >= 0 && extra[k] == optional.size() - num_extra + k )
+        {
+          --k;
+        }
+        if ( k < 0 )
+        {
+          break;
+        }
+        ++extra[k];
+        for ( auto l = uint32_t( k ) + 1u; l < num_extra; ++l )
+        {
+          extra[l] = extra[l - 1u] + 1u;
+        }
+      }
+    }
+
+    return best;
+  }
+
+  /*! \brief Checks all patterns over the variables in `support` */
+  void check_patterns( Cudd const& cudd, std::vector<BDD> const& vars, BDD const& on, BDD const& off, std::vector<uint32_t> const& support )
+  {
+    using kind = dependency_analysis_types::pattern_kind;
+
+    BDD parity = cudd.bddZero();
+    for ( auto const j : support )
+    {
+      parity ^= vars[j];
+    }
+
+    std::vector<uint32_t> fanins;
+    if ( on.Leq( parity ) && off.Leq( !parity ) )
+    {
+      for ( auto const j : support )
+      {
+        fanins.emplace_back( 2u * j );
+      }
+      add_pattern( support.size() == 1u ? kind::EQUAL : kind::XOR, fanins );
+    }
+    else if ( on.Leq( !parity ) && off.Leq( parity ) )
+    {
+      for ( auto const j : support )
+      {
+        fanins.emplace_back( 2u * j + ( support.size() == 1u ? 1u : 0u ) );
+      }
+      add_pattern( support.size() == 1u ? kind::EQUAL : kind::XNOR, fanins );
+    }
+
+    if ( support.size() < 2u )
+    {
+      return;
+    }
+
+    /* the polarities of an AND (NAND) pattern are implied by the on-set (off-set) */
+    for ( auto const nand : {false, true} )
+    {
+      auto const& implying = nand ? off : on;
+      auto const& other = nand ? on : off;
+
+      BDD product = cudd.bddOne();
+      fanins.clear();
+      for ( auto const j : support )
+      {
+        if ( implying.Leq( vars[j] ) )
+        {
+          product &= vars[j];
+          fanins.emplace_back( 2u * j );
+        }
+        else if ( implying.Leq( !vars[j] ) )
+        {
+          product &= !vars[j];
+          fanins.emplace_back( 2u * j + 1u );
+        }
+        else
+        {
+          break;
+        }
+      }
+
+      if ( fanins.size() == support.size() && other.Leq( !product ) )
+      {
+        add_pattern( nand ? kind::NAND : kind::AND, fanins );
+      }
+    }
+  }
+
+  void add_pattern( dependency_analysis_types::pattern_kind kind, std::vector<uint32_t> const& fanins )
+  {
+    dependency_analysis_types::pattern p{kind, fanins};
+    auto const c = pattern_cost( p );
+    if ( c.first > upper_bound )
+    {
+      return;
+    }
+
+    /* same order as `pattern_deps_analysis`: CNOTs, NOTs, and then structure */
+    if ( !best || std::make_tuple( c, p.first, p.second.size(), p.second ) < std::make_tuple( best_cost, best->first, best->second.size(), best->second ) )
+    {
+      best = std::move( p );
+      best_cost = c;
+    }
+  }
+
+private:
+  bdd_deps_analysis_params const& ps;
+  bdd_deps_analysis_stats& st;
+
+  /* BDD of the prepared columns with id `onset_id`, the manager must outlive it */
+  Cudd manager;
+  std::optional<uint64_t> onset_id;
+  BDD function_onset;
+
+  std::optional<dependency_analysis_types::pattern> best;
+  std::pair<uint32_t, uint32_t> best_cost;
+  uint32_t upper_bound;
+};
+
+} /* namespace angel */
@@ -0,0 +1,214 @@
+/* angel: C++ state preparation library
+ * Copyright (C) 2019-2020  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file cascade_dependency_analysis.hpp
+
+  \brief Pattern-based dependency analysis followed by ESOP-based
+         dependency analysis for the remaining targets
+*/
+
+#pragma once
+
+#include "../quantum_state_preparation/utils.hpp"
+#include "../utils/helper_functions.hpp"
+#include "../utils/stopwatch.hpp"
+#include "common.hpp"
+#include "esop_based_dependency_analysis.hpp"
+#include "pattern_based_dependency_analysis.hpp"
+
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/partial_truth_table.hpp>
+
+#include <fmt/format.h>
+
+#include <map>
+#include <numeric>
+#include <vector>
+
+namespace angel
+{
+
+struct cascade_deps_analysis_params
+{
+  /* parameters of the first stage */
+  pattern_deps_analysis_params pattern_ps;
+
+  /* parameters of the second stage */
+  esop_deps_analysis_params esop_ps;
+};
+
+struct cascade_deps_analysis_stats
+{
+  stopwatch<>::duration_type total_time{0};
+  stopwatch<>::duration_type pattern_time{0};
+  stopwatch<>::duration_type esop_time{0};
+
+  /* number of dependencies found by the first and the second stage */
+  uint32_t num_pattern_dependencies{0};
+  uint32_t num_esop_dependencies{0};
+
+  /* number of targets passed to the second stage */
+  uint32_t num_esop_targets{0};
+
+  pattern_deps_analysis_stats pattern_st;
+  esop_deps_analysis_stats esop_st;
+
+  void report() const
+  {
+    fmt::print( "[i] total analysis time = {:8.2f}s\n", to_seconds( total_time ) );
+    fmt::print( "[i]   pattern stage =     {:8.2f}s\n", to_seconds( pattern_time ) );
+    fmt::print( "[i]   ESOP stage =        {:8.2f}s\n", to_seconds( esop_time ) );
+    fmt::print( "[i] dependencies: {} patterns + {} ESOPs ({} targets passed to the ESOP stage)\n",
+                num_pattern_dependencies, num_esop_dependencies, num_esop_targets );
+  }
+
+  void reset()
+  {
+    *this = {};
+  }
+};
+
+struct cascade_deps_analysis_result_type
+{
+  /* maps an index to an ESOP cover, patterns are converted with `esop_from_pattern` */
+  std::map<uint32_t, std::vector<std::vector<uint32_t>>> dependencies;
+
+  void print() const
+  {
+    esop_deps_analysis_result_type{dependencies}.print();
+  }
+};
+
+/*! \brief Cascade of pattern-based and ESOP-based dependency analysis
+
+  The pattern search runs first.  Only targets without a pattern, or
+  with a pattern whose CNOT cost (see `esop_gate_cost`) exceeds the
+  upper bound of the target (see `compute_upperbound_cost`), are passed
+  to the exact ESOP synthesis.  Both stages are kept across calls, such
+  that the ESOP cover cache is shared by all functions.
+*/
+class cascade_deps_analysis
+{
+public:
+  using parameter_type = cascade_deps_analysis_params;
+  using statistics_type = cascade_deps_analysis_stats;
+  using result_type = cascade_deps_analysis_result_type;
+
+public:
+  using function_type = kitty::dynamic_truth_table;
+
+public:
+  explicit cascade_deps_analysis( cascade_deps_analysis_params const& ps, cascade_deps_analysis_stats& st )
+    : ps( ps )
+    , st( st )
+    , pattern_analysis( ps.pattern_ps, st.pattern_st )
+    , esop_analysis( ps.esop_ps, st.esop_st )
+  {
+  }
+
+  cascade_deps_analysis_result_type run( function_type const& function )
+  {
+    return run( function, compute_column_matrix( function ) );
+  }
+
+  /*! \brief Runs the analysis on precomputed column vectors (see `compute_column_matrix`) */
+  cascade_deps_analysis_result_type run( function_type const& function, std::vector<kitty::partial_truth_table> const& column_matrix )
+  {
+    std::vector<uint32_t> targets( column_matrix.size() );
+    std::iota( std::begin( targets ), std::end( targets ), 0u );
+    return run( function, column_matrix, targets );
+  }
+
+  /*! \brief Runs the analysis for some target variables only */
+  cascade_deps_analysis_result_type run( function_type const& function, std::vector<kitty::partial_truth_table> const& column_matrix, std::vector<uint32_t> const& pattern_targets )
+  {
+    return run( function, function_columns( column_matrix ), pattern_targets, true );
+  }
+
+  /*! \brief Runs the analysis for some target variables on prepared columns, both stages share them
+
+    Both stages are always bounded by the upper bound, patterns above it
+    would be replaced by ESOPs anyway.
+  */
+  cascade_deps_analysis_result_type run( function_type const& function, function_columns const& prepared, std::vector<uint32_t> const& pattern_targets, bool use_upperbound )
+  {
+    (void)use_upperbound;
+    stopwatch t( st.total_time );
+
+    uint32_t const num_vars = prepared.columns.size();
+    auto const& zero_lines = prepared.zero_lines;
+    auto const& one_lines = prepared.one_lines;
+
+    /* first stage: patterns */
+    auto const patterns = call_with_stopwatch( st.pattern_time, [&]() {
+      return pattern_analysis.run( function, prepared, pattern_targets, true );
+    } );
+
+    cascade_deps_analysis_result_type result;
+    std::vector<uint32_t> targets;
+    for ( auto const i : pattern_targets )
+    {
+      auto const it = patterns.dependencies.find( i );
+      if ( it != std::end( patterns.dependencies ) )
+      {
+        auto cover = esop_from_pattern( it->second );
+        if ( it->second.first == dependency_analysis_types::pattern_kind::CONST ||
+             esop_gate_cost( cover ).first <= compute_upperbound_cost( zero_lines, one_lines, num_vars, i ) )
+        {
+          result.dependencies[i] = cover;
+          ++st.num_pattern_dependencies;
+          continue;
+        }
+      }
+      targets.emplace_back( i );
+    }
+
+    /* second stage: exact ESOPs for the remaining targets */
+    if ( !targets.empty() )
+    {
+      st.num_esop_targets += targets.size();
+      auto const esops = call_with_stopwatch( st.esop_time, [&]() {
+        return esop_analysis.run( function, prepared, targets, true );
+      } );
+      for ( auto const& [i, cover] : esops.dependencies )
+      {
+        result.dependencies[i] = cover;
+        ++st.num_esop_dependencies;
+      }
+    }
+
+    return result;
+  }
+
+private:
+  cascade_deps_analysis_params const& ps;
+  cascade_deps_analysis_stats& st;
+
+  pattern_deps_analysis pattern_analysis;
+  esop_deps_analysis esop_analysis;
+};
+
+} /* namespace angel */
@@ -34,9 +34,15 @@
 
 #pragma once
 
+#include "../utils/column_matrix.hpp"
+
 #include <kitty/dynamic_truth_table.hpp>
 #include <kitty/partial_truth_table.hpp>
 #include <fmt/format.h>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <utility>
 #include <vector>
 
 namespace angel
@@ -101,10 +107,188 @@ struct dependency_analysis_types
   }
 }; /* dependency_analysis_types */
 
+/*! \brief Wraps the column vectors of a function (see `compute_column_matrix`) as indexed columns */
+inline std::vector<dependency_analysis_types::column> create_columns( std::vector<kitty::partial_truth_table> const& column_matrix )
+{
+  std::vector<dependency_analysis_types::column> columns( column_matrix.size() );
+  for ( auto i = 0u; i < columns.size(); ++i )
+  {
+    columns[i].tt = column_matrix[i];
+    columns[i].index = i;
+  }
+  return columns;
+}
+
+/*! \brief Column vectors of a function, prepared once for the analyses of all its targets
+
+  Holds the indexed columns, their complements, and the constant
+  columns.  Analyses that keep more data per function (such as XOR
+  bases) recognize the function by `id`, which is unique for each
+  prepared function.
+*/
+struct function_columns
+{
+  explicit function_columns( std::vector<kitty::partial_truth_table> const& column_matrix )
+    : columns( create_columns( column_matrix ) )
+    , id( next_id() )
+  {
+    complemented_columns.reserve( columns.size() );
+    for ( auto i = 0u; i < columns.size(); ++i )
+    {
+      complemented_columns.emplace_back( ~columns[i].tt );
+      if ( kitty::is_const0( columns[i].tt ) )
+      {
+        zero_lines.emplace_back( i );
+      }
+      else if ( kitty::is_const0( complemented_columns[i] ) )
+      {
+        one_lines.emplace_back( i );
+      }
+    }
+  }
+
+  std::vector<dependency_analysis_types::column> columns;
+  std::vector<kitty::partial_truth_table> complemented_columns;
+  std::vector<uint32_t> zero_lines, one_lines;
+  uint64_t id;
+
+private:
+  static uint64_t next_id()
+  {
+    static std::atomic<uint64_t> counter{0};
+    return counter++;
+  }
+};
+
+/*! \brief Renames the fanin literals of a pattern, variable `v` becomes `names[v]` */
+inline dependency_analysis_types::pattern rename_dependency( dependency_analysis_types::pattern const& p, std::vector<uint32_t> const& names )
+{
+  if ( p.first == dependency_analysis_types::pattern_kind::CONST )
+  {
+    return p;
+  }
+
+  dependency_analysis_types::pattern renamed{p.first, {}};
+  for ( auto const& lit : p.second )
+  {
+    renamed.second.emplace_back( 2u * names[lit / 2u] + ( lit % 2u ) );
+  }
+  return renamed;
+}
+
+/*! \brief Renames the literals of an ESOP cover, variable `v` becomes `names[v]` */
+inline std::vector<std::vector<uint32_t>> rename_dependency( std::vector<std::vector<uint32_t>> const& cover, std::vector<uint32_t> const& names )
+{
+  std::vector<std::vector<uint32_t>> renamed;
+  for ( auto const& cube : cover )
+  {
+    renamed.emplace_back();
+    for ( auto const& lit : cube )
+    {
+      renamed.back().emplace_back( 2u * names[lit / 2u] + ( lit % 2u ) );
+    }
+  }
+  return renamed;
+}
+
+/*! \brief Number of CNOTs and single-qubit gates to prepare a target from a pattern */
+inline std::pair<uint32_t, uint32_t> pattern_cost( dependency_analysis_types::pattern const& p )
+{
+  assert( p.second.size() > 0u );
+  switch ( p.first )
+  {
+  case dependency_analysis_types::pattern_kind::EQUAL:
+  {
+    assert( p.second.size() == 1u );
+    return {1u, p.second[0] % 2u};
+  }
+  case dependency_analysis_types::pattern_kind::XOR:
+  {
+    return {p.second.size(), 0u};
+  }
+  case dependency_analysis_types::pattern_kind::XNOR:
+  {
+    return {p.second.size(), 1u};
+  }
+  case dependency_analysis_types::pattern_kind::AND:
+  {
+    auto const n = p.second.size();
+    auto polarity_counter = 0u;
+    for ( auto i = 0u; i < n; ++i )
+    {
+      polarity_counter += 2u * ( p.second[i] % 2 );
+    }
+    return {( 1u << n ), polarity_counter + ( 1u << n )};
+  }
+  case dependency_analysis_types::pattern_kind::NAND:
+  {
+    auto const n = p.second.size();
+    auto polarity_counter = 1u;
+    for ( auto i = 0u; i < n; ++i )
+    {
+      polarity_counter += 2u * ( p.second[i] % 2 );
+    }
+    return {( 1u << n ), polarity_counter + ( 1u << n )};
+  }
+  default:
+    std::abort();
+  }
+}
+
+/*! \brief Converts a pattern into an equivalent ESOP cover
+
+  A constant becomes the empty cover (false) or the cover with one empty
+  cube (true), complemented patterns get an additional empty cube.
+*/
+inline std::vector<std::vector<uint32_t>> esop_from_pattern( dependency_analysis_types::pattern const& p )
+{
+  using kind = dependency_analysis_types::pattern_kind;
+
+  std::vector<std::vector<uint32_t>> cover;
+  switch ( p.first )
+  {
+  case kind::CONST:
+    if ( p.second[0u] == 1u )
+    {
+      cover.emplace_back();
+    }
+    break;
+  case kind::EQUAL:
+  case kind::AND:
+    cover.emplace_back( p.second );
+    break;
+  case kind::NAND:
+    cover.emplace_back( p.second );
+    cover.emplace_back();
+    break;
+  case kind::XOR:
+  case kind::XNOR:
+    for ( auto const& lit : p.second )
+    {
+      cover.push_back( {lit} );
+    }
+    if ( p.first == kind::XNOR )
+    {
+      cover.emplace_back();
+    }
+    break;
+  default:
+    std::abort();
+  }
+  return cover;
+}
+
 template<typename Algorithm>
 typename Algorithm::result_type compute_dependencies( kitty::dynamic_truth_table const &tt, typename Algorithm::parameter_type const& ps, typename Algorithm::statistics_type& st )
 {
   return Algorithm( ps, st ).run( tt );
 }
 
+template<typename Algorithm>
+typename Algorithm::result_type compute_dependencies( kitty::dynamic_truth_table const &tt, std::vector<kitty::partial_truth_table> const& column_matrix,
+                                                      typename Algorithm::parameter_type const& ps, typename Algorithm::statistics_type& st )
+{
+  return Algorithm( ps, st ).run( tt, column_matrix );
+}
+
 } /* namespace angel */
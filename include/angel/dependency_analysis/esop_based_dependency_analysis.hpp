@@ -34,9 +34,13 @@
 
 #pragma once
 
+#include "../quantum_state_preparation/utils.hpp"
+#include "../utils/lru_cache.hpp"
 #include "../utils/stopwatch.hpp"
 #include "common.hpp"
 
+#include <easy/esop/esop_from_pkrm.hpp>
+#include <easy/esop/esop_from_pprm.hpp>
 #include <easy/exact_esop_cover_from_divisors.hpp>
 
 #include <kitty/implicant.hpp>
@@ -45,24 +49,151 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <map>
+#include <numeric>
+#include <optional>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace angel
 {
 
+namespace detail
+{
+
+/*! \brief Relative distinguishing power of two columns of `num_rows` bits with `ones_a` and `ones_b` ones
+
+  The measure is symmetric and only depends on the number of ones in both
+  columns and in their AND, such that one word-parallel popcount pass
+  suffices.
+*/
+inline uint64_t pair_distinguishing_power( kitty::partial_truth_table const& a, kitty::partial_truth_table const& b, uint64_t num_rows, uint64_t ones_a, uint64_t ones_b )
+{
+  uint64_t both = 0u;
+  for ( auto w = 0u; w < a._bits.size(); ++w )
+  {
+    both += __builtin_popcountll( a._bits[w] & b._bits[w] );
+  }
+
+  /* pairs distinguished in the on-set and in the off-set of column a */
+  return ( num_rows - ones_a - ones_b + both ) * both + ( ones_a - both ) * ( ones_b - both );
+}
+
+/*! \brief Rows of the distinguishing power matrix for some targets
+
+  Entry `i * n + j` is `kitty::relative_distinguishing_power( c_j, c_i )`
+  for `n` columns.  Only the entries with `j > i` of every target `i` are
+  computed, all other entries are zero.
+*/
+inline std::vector<uint64_t> compute_distinguishing_power_matrix( std::vector<dependency_analysis_types::column> const& columns, std::vector<uint32_t> const& targets )
+{
+  uint32_t const num_vars = columns.size();
+  uint64_t const num_rows = num_vars > 0u ? columns[0u].tt.num_bits() : 0u;
+
+  std::vector<uint64_t> ones( num_vars );
+  for ( auto i = 0u; i < num_vars; ++i )
+  {
+    ones[i] = kitty::count_ones( columns[i].tt );
+  }
+
+  std::vector<uint64_t> power( num_vars * num_vars, 0u );
+  for ( auto const i : targets )
+  {
+    for ( auto j = i + 1u; j < num_vars; ++j )
+    {
+      power[i * num_vars + j] = pair_distinguishing_power( columns[i].tt, columns[j].tt, num_rows, ones[i], ones[j] );
+    }
+  }
+  return power;
+}
+
+/*! \brief Relative distinguishing power of every pair of columns
+
+  Computes the rows of all targets and mirrors them, since the measure
+  is symmetric.
+*/
+inline std::vector<uint64_t> compute_distinguishing_power_matrix( std::vector<dependency_analysis_types::column> const& columns )
+{
+  uint32_t const num_vars = columns.size();
+  std::vector<uint32_t> targets( num_vars );
+  std::iota( std::begin( targets ), std::end( targets ), 0u );
+
+  auto power = compute_distinguishing_power_matrix( columns, targets );
+  for ( auto i = 0u; i < num_vars; ++i )
+  {
+    for ( auto j = i + 1u; j < num_vars; ++j )
+    {
+      power[j * num_vars + i] = power[i * num_vars + j];
+    }
+  }
+  return power;
+}
+
+} /* namespace detail */
+
 struct esop_deps_analysis_params
 {
+  /* compute a PPRM/PKRM cover before exact synthesis and use its cost as bound */
+  bool use_heuristic{true};
+
+  /* maximum number of divisors for the PPRM and the PKRM cover (both are exponential in the number of divisors) */
+  uint32_t max_pprm_divisors{12u};
+  uint32_t max_pkrm_divisors{8u};
+
+  /* skip exact synthesis if the heuristic cover is not more expensive than the upper bound (see `compute_upperbound_cost`) */
+  bool accept_heuristic_below_upperbound{false};
+
+  /* reuse covers of covering problems with the same rows; a full cache evicts its least recently used cover */
+  bool use_cache{true};
+  uint32_t max_cache_size{100000u};
+
+  /* conflict limit of each SAT call in exact synthesis (0 means no limit) */
+  uint32_t num_conflicts{1000u};
+
+  /* wall-clock budgets in milliseconds per target and per function (0 means no limit); a target that runs
+     out of time keeps the best cover found so far or gets no dependency, targets after the function budget
+     get no dependency */
+  uint32_t target_time_limit{0u};
+  uint32_t function_time_limit{0u};
 };
 
 struct esop_deps_analysis_stats
 {
   stopwatch<>::duration_type total_time{0};
+  stopwatch<>::duration_type heuristic_time{0};
+  stopwatch<>::duration_type exact_time{0};
 
   uint32_t num_patterns{0};
 
+  /* number of covers taken from the heuristic without exact synthesis */
+  uint32_t num_heuristic_covers{0};
+
+  /* number of exact syntheses and number of them that improved on the heuristic cover */
+  uint32_t num_exact_syntheses{0};
+  uint32_t num_exact_improvements{0};
+
+  /* number of covering problems found in and missing from the cover cache */
+  uint32_t num_cache_hits{0};
+  uint32_t num_cache_misses{0};
+
+  /* number of targets that ran out of time, of functions that ran out of time, and of targets skipped for that */
+  uint32_t num_target_timeouts{0};
+  uint32_t num_function_timeouts{0};
+  uint32_t num_skipped_targets{0};
+
   void report() const
   {
+    fmt::print( "[i] total analysis time = {:8.2f}s\n", to_seconds( total_time ) );
+    fmt::print( "[i]   heuristic covers =  {:8.2f}s\n", to_seconds( heuristic_time ) );
+    fmt::print( "[i]   exact synthesis =   {:8.2f}s\n", to_seconds( exact_time ) );
+    fmt::print( "[i] patterns: {}\n", num_patterns );
+    fmt::print( "[i] heuristic covers accepted: {}, exact syntheses: {} ({} improved)\n", num_heuristic_covers, num_exact_syntheses, num_exact_improvements );
+    fmt::print( "[i] cover cache: {} hits, {} misses\n", num_cache_hits, num_cache_misses );
+    fmt::print( "[i] timeouts: {} targets, {} functions ({} targets skipped)\n", num_target_timeouts, num_function_timeouts, num_skipped_targets );
   }
 
   void reset()
@@ -110,126 +241,147 @@ public:
 
 public:
   explicit esop_deps_analysis( esop_deps_analysis_params const& ps, esop_deps_analysis_stats& st )
-      : ps( ps ), st( st )
+      : ps( ps ), st( st ), cover_cache( ps.max_cache_size )
   {
   }
 
-  esop_deps_analysis_result_type run( function_type const& function ) const
+  esop_deps_analysis_result_type run( function_type const& function )
   {
-    stopwatch t( st.total_time );
+    return run( function, compute_column_matrix( function ) );
+  }
 
-    /* create column vectors */
-    uint32_t const num_vars = function.num_vars();
-    std::vector<dependency_analysis_types::column> columns{num_vars};
-    for ( auto i = 0u; i < columns.size(); ++i )
-    {
-      columns[i].index = i;
-    }
+  /*! \brief Runs the analysis on precomputed column vectors (see `compute_column_matrix`) */
+  esop_deps_analysis_result_type run( function_type const& function, std::vector<kitty::partial_truth_table> const& column_matrix )
+  {
+    std::vector<uint32_t> targets( column_matrix.size() );
+    std::iota( std::begin( targets ), std::end( targets ), 0u );
+    return run( function, column_matrix, targets );
+  }
 
-    kitty::dynamic_truth_table minterm{function.num_vars()};
-    for ( auto const& m : kitty::get_minterms( function ) )
-    {
-      minterm._bits[0] = m;
-      for ( auto i = 0; i < minterm.num_vars(); ++i )
-      {
-        columns[i].tt.add_bit( kitty::get_bit( minterm, i ) );
-      }
-    }
+  /*! \brief Runs the analysis for some target variables only */
+  esop_deps_analysis_result_type run( function_type const& function, std::vector<kitty::partial_truth_table> const& column_matrix, std::vector<uint32_t> const& targets )
+  {
+    return run( function, function_columns( column_matrix ), targets, true );
+  }
+
+  /*! \brief Runs the analysis for some target variables on prepared columns, ESOPs are always bounded by the upper bound */
+  esop_deps_analysis_result_type run( function_type const& function, function_columns const& prepared, std::vector<uint32_t> const& targets, bool use_upperbound )
+  {
+    (void)function;
+    (void)use_upperbound;
+    stopwatch t( st.total_time );
 
-    // for ( const auto& c : columns )
-    // {
-    //   kitty::print_binary( c.tt ); std::cout << std::endl;
-    // }
+    auto const& columns = prepared.columns;
+    auto const& zero_lines = prepared.zero_lines;
+    auto const& one_lines = prepared.one_lines;
+    uint32_t const num_vars = columns.size();
 
     esop_deps_analysis_result_type result;
 
     /* collect divisors */
-    std::vector<dependency_analysis_types::column> columns_copy;
-    for ( auto i = 0u; i < columns.size(); ++i )
+    auto const power = detail::compute_distinguishing_power_matrix( columns, targets );
+    auto const function_deadline = deadline_after( ps.function_time_limit );
+    bool function_timed_out = false;
+    std::vector<uint32_t> divisors;
+    for ( auto const i : targets )
     {
-      /* copy the original columns */
-      columns_copy = std::vector<dependency_analysis_types::column>( std::begin( columns ) + i, std::end( columns ) );
-
-      /* initialize entropy field */
-      {
-        auto& target = columns_copy[0];
-        target.entropy = std::numeric_limits<uint64_t>::max();
-
-        for ( auto j = 1u; j < columns_copy.size(); ++j )
-        {
-          auto& sig = columns_copy[j];
-          sig.entropy = kitty::relative_distinguishing_power( sig.tt, target.tt );
-        }
-      }
-
-      /* sort by entropy (highest entropy first) */
-      std::sort( std::rbegin( columns_copy ), std::rend( columns_copy ), [&]( auto const& a, auto const& b ) {
-        return a.entropy < b.entropy || ( a.entropy == b.entropy && a.index > b.index );
-      } );
-
-      /* overwrite the entropy of the target */
-      auto& target = columns_copy[0];
-      target.entropy = kitty::absolute_distinguishing_power( target.tt );
-
       /* skip constants */
-      if ( kitty::is_const0( target.tt ) )
+      if ( kitty::is_const0( columns[i].tt ) )
       {
         /* false */
-        result.dependencies[target.index] = std::vector<std::vector<uint32_t>>{};
+        result.dependencies[i] = std::vector<std::vector<uint32_t>>{};
         continue;
       }
-      else if ( kitty::is_const0( ~target.tt ) )
+      else if ( kitty::is_const0( prepared.complemented_columns[i] ) )
       {
         /* true */
-        result.dependencies[target.index] = std::vector<std::vector<uint32_t>>{{}};
+        result.dependencies[i] = std::vector<std::vector<uint32_t>>{{}};
+        continue;
+      }
+
+      if ( clock::now() >= function_deadline )
+      {
+        if ( !function_timed_out )
+        {
+          function_timed_out = true;
+          ++st.num_function_timeouts;
+        }
+        ++st.num_skipped_targets;
         continue;
       }
+      auto const target_deadline = std::min( function_deadline, deadline_after( ps.target_time_limit ) );
+
+      /* sort the columns after the target by distinguishing power (highest first) */
+      uint64_t const* target_power = &power[i * num_vars];
+      divisors.resize( num_vars - i - 1u );
+      std::iota( std::begin( divisors ), std::end( divisors ), i + 1u );
+      std::stable_sort( std::begin( divisors ), std::end( divisors ), [&]( auto a, auto b ) {
+        return target_power[a] > target_power[b];
+      } );
 
-      /* print */
-      // std::cout << "===========================================================================" << std::endl;
-      // std::cout << "target = "; kitty::print_binary( target.tt ); std::cout << ' ' << target.entropy << std::endl;
-      //
-      // for ( auto j = 1u; j < columns_copy.size(); ++j )
-      // {
-      //   std::cout << columns_copy[j].index << ' '; kitty::print_binary( columns_copy[j].tt ); std::cout << ' ' << columns_copy[j].entropy << std::endl;
-      // }
+      uint64_t const target_entropy = kitty::absolute_distinguishing_power( columns[i].tt );
 
       /* try to cover the target using the columns */
-      uint32_t current_entropy;
+      auto const upper_bound = compute_upperbound_cost( zero_lines, one_lines, num_vars, i );
+      uint64_t current_entropy;
       std::vector<uint32_t> indices;
 
       bool found = false;
-      for ( auto j = 1u; j < columns_copy.size() && !found; ++j )
+      bool timed_out = false;
+      for ( auto j = 0u; j < divisors.size() && !found && !timed_out; ++j )
       {
         current_entropy = 0u;
         indices.clear();
 
-        for ( auto k = j; k < columns_copy.size() && !found; ++k )
+        for ( auto k = j; k < divisors.size() && !found && !timed_out; ++k )
         {
-          indices.push_back( columns_copy[k].index );
-          current_entropy += columns_copy[k].entropy;
+          indices.push_back( divisors[k] );
+          current_entropy += target_power[divisors[k]];
 
-          if ( current_entropy >= target.entropy )
+          if ( current_entropy >= target_entropy )
           {
-            auto const pattern = on_candidate( columns, target.index, indices );
+            if ( clock::now() >= target_deadline )
+            {
+              timed_out = true;
+              break;
+            }
+
+            auto const pattern = on_candidate( columns, i, indices, upper_bound, target_deadline, timed_out );
             if ( pattern )
             {
               found = true;
-              result.dependencies[target.index] = *pattern;
+              result.dependencies[i] = *pattern;
               ++st.num_patterns;
               break;
             }
           }
         }
       }
+
+      if ( timed_out )
+      {
+        ++st.num_target_timeouts;
+      }
     }
 
     return result;
   }
 
 private:
+  /* ESOP cover over divisor positions: literal 2*i+1 is the complement of the i-th divisor */
+  using cover_type = std::vector<std::vector<uint32_t>>;
+
+  using clock = std::chrono::steady_clock;
+
+  /* deadline `time_limit` milliseconds from now, a time limit of 0 never expires */
+  static clock::time_point deadline_after( uint32_t time_limit )
+  {
+    return time_limit == 0u ? clock::time_point::max() : clock::now() + std::chrono::milliseconds( time_limit );
+  }
+
   std::optional<std::vector<std::vector<uint32_t>>>
-  on_candidate( std::vector<dependency_analysis_types::column> const& columns, uint32_t target_index, std::vector<uint32_t> const& divisor_indices ) const
+  on_candidate( std::vector<dependency_analysis_types::column> const& columns, uint32_t target_index, std::vector<uint32_t> const& divisor_indices, uint32_t upper_bound,
+                clock::time_point deadline, bool& timed_out )
   {
     std::vector<kitty::partial_truth_table> functions;
     for ( const auto& i : divisor_indices )
@@ -237,57 +389,242 @@ private:
       functions.push_back( columns[i].tt );
     }
 
-    if ( is_covered_with_divisors( columns[target_index].tt, functions ) )
+    auto const& target = columns[target_index].tt;
+    auto const signatures = compute_row_signatures( functions );
+
+    std::optional<cover_type> cover;
+    if ( ps.use_cache )
+    {
+      auto key = canonical_problem( target, signatures, functions.size(), upper_bound );
+      if ( auto const cached = cover_cache.find( key ) )
+      {
+        ++st.num_cache_hits;
+        cover = *cached;
+      }
+      else
+      {
+        ++st.num_cache_misses;
+        cover = compute_cover( target, functions, signatures, upper_bound, deadline, timed_out );
+
+        /* covers of interrupted syntheses depend on timing and are not reused */
+        if ( !timed_out )
+        {
+          cover_cache.insert( key, cover );
+        }
+      }
+    }
+    else
+    {
+      cover = compute_cover( target, functions, signatures, upper_bound, deadline, timed_out );
+    }
+
+    if ( !cover )
+    {
+      return std::nullopt;
+    }
+
+    /* rename divisor positions to column indices */
+    for ( auto& cube : *cover )
+    {
+      for ( auto& lit : cube )
+      {
+        lit = 2u * divisor_indices[lit / 2u] + ( lit % 2u );
+      }
+    }
+    return cover;
+  }
+
+  /*! \brief Canonical form of a covering problem
+
+    The problem only depends on the distinct pairs of a row signature and
+    the target value in that row, and not on the order or multiplicity of
+    the rows.  The key lists these pairs in increasing order after the
+    number of divisors and, if heuristic covers are accepted below the
+    upper bound, the upper bound.
+  */
+  std::vector<uint64_t> canonical_problem( kitty::partial_truth_table const& target, std::vector<uint64_t> const& signatures, uint32_t num_divisors, uint32_t upper_bound ) const
+  {
+    std::vector<uint64_t> key;
+    key.reserve( signatures.size() + 2u );
+    for ( uint32_t l = 0u; l < signatures.size(); ++l )
+    {
+      key.emplace_back( ( signatures[l] << 1u ) | uint64_t( kitty::get_bit( target, l ) ) );
+    }
+    std::sort( std::begin( key ), std::end( key ) );
+    key.erase( std::unique( std::begin( key ), std::end( key ) ), std::end( key ) );
+
+    key.insert( std::begin( key ), { num_divisors, ps.accept_heuristic_below_upperbound ? upper_bound : 0u } );
+    return key;
+  }
+
+  /* computes the cheapest ESOP cover over divisor positions that can be found, if the divisors cover the target */
+  std::optional<cover_type> compute_cover( kitty::partial_truth_table const& target, std::vector<kitty::partial_truth_table> const& functions,
+                                           std::vector<uint64_t> const& signatures, uint32_t upper_bound, clock::time_point deadline, bool& timed_out ) const
+  {
+    if ( !is_covered_with_divisors( target, signatures ) )
+    {
+      return std::nullopt;
+    }
+
+    easy::compute_esop_cover_from_divisors_parameters esop_ps;
+    esop_ps.num_conflicts = ps.num_conflicts;
+    std::optional<cover_type> heuristic_cover;
+    uint32_t heuristic_cost = std::numeric_limits<uint32_t>::max();
+    if ( ps.use_heuristic && functions.size() <= ps.max_pprm_divisors )
+    {
+      stopwatch t( st.heuristic_time );
+      heuristic_cover = compute_heuristic_cover( target, functions.size(), signatures );
+
+      heuristic_cost = esop_gate_cost( *heuristic_cover ).first;
+      if ( heuristic_cost <= cost_lower_bound( target, functions ) || ( ps.accept_heuristic_below_upperbound && heuristic_cost <= upper_bound ) )
+      {
+        ++st.num_heuristic_covers;
+        return heuristic_cover;
+      }
+
+      /* exact synthesis only needs to find cheaper covers */
+      esop_ps.max_cost = heuristic_cost;
+    }
+
+    if ( deadline != clock::time_point::max() )
+    {
+      auto const remaining = std::chrono::duration_cast<std::chrono::milliseconds>( deadline - clock::now() ).count();
+      esop_ps.time_limit = std::max<int64_t>( remaining, 1 );
+    }
+
+    stopwatch t( st.exact_time );
+    ++st.num_exact_syntheses;
+    easy::compute_esop_cover_from_divisors_statistics esop_st;
+    auto const result = easy::compute_exact_esop_cover_from_divisors( target, functions, esop_ps, esop_st );
+    timed_out = esop_st.timed_out;
+    if ( !result.esop_cover )
     {
-      auto const result = easy::compute_exact_esop_cover_from_divisors( columns[target_index].tt, functions );
-      if ( result.esop_cover )
+      return heuristic_cover;
+    }
+
+    /* re-encode ESOP cover */
+    cover_type esop_cover;
+    std::vector<uint32_t> new_cube;
+    for ( auto const& cube : *result.esop_cover )
+    {
+      new_cube.clear();
+      for ( auto i = 0u; i < functions.size(); ++i )
       {
-        /* re-encode ESOP cover */
-        std::vector<std::vector<uint32_t>> esop_cover;
-        std::vector<uint32_t> new_cube;
-        for ( auto const& cube : *result.esop_cover )
+        if ( cube.get_mask( i ) )
         {
-          new_cube.clear();
-          for ( auto i = 0u; i < divisor_indices.size(); ++i )
-          {
-            if ( cube.get_mask( i ) )
-            {
-              new_cube.push_back( cube.get_bit( i ) ? 2u * divisor_indices[i] : 2u * divisor_indices[i] + 1 );
-            }
-          }
-          esop_cover.push_back( new_cube );
+          new_cube.push_back( cube.get_bit( i ) ? 2u * i : 2u * i + 1 );
         }
-        return esop_cover;
       }
+      esop_cover.push_back( new_cube );
     }
-    return std::nullopt;
+
+    /* the cost model of the exact synthesis slightly differs from `esop_gate_cost` */
+    if ( heuristic_cover )
+    {
+      if ( esop_cover.empty() || esop_gate_cost( esop_cover ).first >= heuristic_cost )
+      {
+        return heuristic_cover;
+      }
+      ++st.num_exact_improvements;
+    }
+    return esop_cover;
   }
 
-  bool is_covered_with_divisors( kitty::partial_truth_table const& target, std::vector<kitty::partial_truth_table> const& divisors ) const
+  /*! \brief Computes an ESOP cover of the target from PPRM and PKRM expansions
+
+    The target is a partial function of the divisors: rows that do not
+    occur are don't cares and are assigned 0.  The cheaper of the PPRM
+    and the optimum PKRM of the resulting function is returned, with the
+    cube that saves most CNOTs in the first position (see
+    `esop_gate_cost`).  The divisors must cover the target.
+  */
+  cover_type compute_heuristic_cover( kitty::partial_truth_table const& target, uint32_t num_divisors, std::vector<uint64_t> const& signatures ) const
   {
-    /* iterate over all bit pairs of target */
-    for ( uint32_t i = 0u; i < uint32_t( target.num_bits() ); ++i )
+    kitty::dynamic_truth_table function( num_divisors );
+    for ( uint32_t l = 0u; l < signatures.size(); ++l )
     {
-      for ( uint32_t j = i + 1u; j < uint32_t( target.num_bits() ); ++j )
+      if ( kitty::get_bit( target, l ) )
+      {
+        kitty::set_bit( function, signatures[l] );
+      }
+    }
+
+    auto const to_cover = [&]( easy::esop::esop_t const& esop ) {
+      cover_type cover;
+      for ( auto const& cube : esop )
       {
-        if ( get_bit( target, i ) != get_bit( target, j ) )
+        std::vector<uint32_t> lits;
+        for ( auto i = 0u; i < num_divisors; ++i )
         {
-          /* check if this bit pair is distinguished by a divisor */
-          bool found = false;
-          for ( const auto& d : divisors )
+          if ( cube.get_mask( i ) )
           {
-            if ( get_bit( d, i ) != get_bit( d, j ) )
-            {
-              found = true;
-              break;
-            }
+            lits.push_back( cube.get_bit( i ) ? 2u * i : 2u * i + 1 );
           }
+        }
+        cover.push_back( lits );
+      }
 
-          if ( !found )
-          {
-            return false;
-          }
+      /* choose the first cube */
+      auto best_cost = esop_gate_cost( cover ).first;
+      for ( auto i = 1u; i < cover.size(); ++i )
+      {
+        std::swap( cover[0u], cover[i] );
+        auto const cost = esop_gate_cost( cover ).first;
+        if ( cost < best_cost )
+        {
+          best_cost = cost;
         }
+        else
+        {
+          std::swap( cover[0u], cover[i] );
+        }
+      }
+      return std::make_pair( cover, best_cost );
+    };
+
+    auto best = to_cover( easy::esop::esop_from_pprm( function ) );
+    if ( num_divisors <= ps.max_pkrm_divisors )
+    {
+      auto pkrm = to_cover( easy::esop::esop_from_optimum_pkrm( function ) );
+      if ( pkrm.second < best.second )
+      {
+        best = pkrm;
+      }
+    }
+    return best.first;
+  }
+
+  /* a non-constant target costs at least one CNOT, and at least two if it is not a literal */
+  uint32_t cost_lower_bound( kitty::partial_truth_table const& target, std::vector<kitty::partial_truth_table> const& divisors ) const
+  {
+    for ( auto const& divisor : divisors )
+    {
+      if ( divisor == target || divisor == ~target )
+      {
+        return 1u;
+      }
+    }
+    return 2u;
+  }
+
+  /*! \brief Checks if the divisors distinguish all rows in which the target differs
+
+    Rows with the same divisor values (signature) must have the same
+    target value, which is checked by hashing the signature of every
+    row.  This is a necessary condition for an ESOP cover of the target
+    over the divisors and is checked before any SAT call.
+  */
+  bool is_covered_with_divisors( kitty::partial_truth_table const& target, std::vector<uint64_t> const& signatures ) const
+  {
+    std::unordered_map<uint64_t, bool> target_values;
+    target_values.reserve( signatures.size() );
+    for ( uint32_t l = 0u; l < signatures.size(); ++l )
+    {
+      bool const value = kitty::get_bit( target, l );
+      auto const [it, inserted] = target_values.emplace( signatures[l], value );
+      if ( !inserted && it->second != value )
+      {
+        return false;
       }
     }
     return true;
@@ -296,6 +633,9 @@ private:
 private:
   esop_deps_analysis_params const& ps;
   esop_deps_analysis_stats& st;
+
+  /* covers of canonical covering problems, kept across targets and functions (which makes `run` non-const) */
+  lru_cache<std::vector<uint64_t>, std::optional<cover_type>> cover_cache;
 };
 
 } /* namespace angel */
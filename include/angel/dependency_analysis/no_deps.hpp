@@ -1,6 +1,11 @@
+#include "common.hpp"
+
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/partial_truth_table.hpp>
 #include <map>
 #include <fmt/format.h>
 #include <iostream>
+#include <vector>
 
 namespace angel
 {
@@ -54,6 +59,27 @@ public:
     return no_deps_analysis_result_type{};
   }
 
+  no_deps_analysis_result_type run( function_type const& function, std::vector<kitty::partial_truth_table> const& column_matrix ) const
+  {
+    (void)column_matrix;
+    return run( function );
+  }
+
+  no_deps_analysis_result_type run( function_type const& function, std::vector<kitty::partial_truth_table> const& column_matrix, std::vector<uint32_t> const& targets ) const
+  {
+    (void)column_matrix;
+    (void)targets;
+    return run( function );
+  }
+
+  no_deps_analysis_result_type run( function_type const& function, function_columns const& prepared, std::vector<uint32_t> const& targets, bool use_upperbound ) const
+  {
+    (void)prepared;
+    (void)targets;
+    (void)use_upperbound;
+    return run( function );
+  }
+
 private:
   no_deps_analysis_params const& ps;
   no_deps_analysis_stats& st;
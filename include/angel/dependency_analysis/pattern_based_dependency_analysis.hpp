@@ -36,14 +36,163 @@
 
 #include "common.hpp"
 
+#include "../quantum_state_preparation/utils.hpp"
 #include "../utils/stopwatch.hpp"
 
 #include <kitty/kitty.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
 #include <map>
+#include <numeric>
+#include <optional>
+#include <thread>
 
 namespace angel
 {
 
+namespace detail
+{
+
+/*! \brief Checks if two bit-vectors of `num_blocks` words are equal
+
+  The comparison stops at the first word that does not match.
+*/
+inline bool is_equal( uint64_t const* a, uint64_t const* b, uint32_t num_blocks )
+{
+  for ( auto i = 0u; i < num_blocks; ++i )
+  {
+    if ( a[i] != b[i] )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*! \brief Checks if the AND of two bit-vectors is equal to the target
+
+  All arguments point to `num_blocks` 64-bit words.  The comparison stops
+  at the first word that does not match.
+*/
+inline bool and_equals( uint64_t const* a, uint64_t const* b, uint64_t const* target, uint32_t num_blocks )
+{
+  for ( auto i = 0u; i < num_blocks; ++i )
+  {
+    if ( ( a[i] & b[i] ) != target[i] )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*! \brief Checks if two bit-vectors of `num_blocks` words have no common bit */
+inline bool is_disjoint( uint64_t const* a, uint64_t const* b, uint32_t num_blocks )
+{
+  for ( auto i = 0u; i < num_blocks; ++i )
+  {
+    if ( ( a[i] & b[i] ) != 0u )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*! \brief Checks if a bit-vector of `num_blocks` words is zero */
+inline bool is_zero( uint64_t const* a, uint32_t num_blocks )
+{
+  for ( auto i = 0u; i < num_blocks; ++i )
+  {
+    if ( a[i] != 0u )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*! \brief Bases of the column space spanned by each suffix of columns
+
+  The columns are inserted from the last to the first one, such that the
+  first `rank( s )` basis vectors span the columns `s, ..., n-1`.  Only
+  the suffixes starting at `first` or later are computed.
+*/
+class xor_suffix_basis
+{
+public:
+  void compute( std::vector<dependency_analysis_types::column> const& columns, uint32_t first = 0u )
+  {
+    uint32_t const num_vars = columns.size();
+    num_blocks = num_vars > 0u ? columns[0u].tt.num_blocks() : 0u;
+
+    basis.clear();
+    pivots.clear();
+    suffix_rank.assign( num_vars + 1u, 0u );
+    computed_first = num_vars;
+    extend( columns, first );
+  }
+
+  /*! \brief Also computes the suffixes starting at `first, ..., computed_first - 1` */
+  void extend( std::vector<dependency_analysis_types::column> const& columns, uint32_t first )
+  {
+    std::vector<uint64_t> residual( num_blocks );
+
+    for ( int32_t s = int32_t( computed_first ) - 1; s >= int32_t( first ); --s )
+    {
+      std::copy( columns[s].tt._bits.begin(), columns[s].tt._bits.begin() + num_blocks, residual.begin() );
+      reduce( residual.data(), pivots.size() );
+
+      for ( auto b = 0u; b < num_blocks; ++b )
+      {
+        if ( residual[b] != 0u )
+        {
+          pivots.emplace_back( 64u * b + __builtin_ctzll( residual[b] ) );
+          basis.insert( std::end( basis ), std::begin( residual ), std::end( residual ) );
+          break;
+        }
+      }
+      suffix_rank[s] = pivots.size();
+    }
+    computed_first = std::min( computed_first, first );
+  }
+
+  /*! \brief Rank of the columns `first, ..., n-1` */
+  uint32_t rank( uint32_t first ) const
+  {
+    return suffix_rank[first];
+  }
+
+  /*! \brief Reduces a bit-vector with the first `rank` basis vectors */
+  void reduce( uint64_t* v, uint32_t rank ) const
+  {
+    for ( auto r = 0u; r < rank; ++r )
+    {
+      auto const pivot = pivots[r];
+      if ( ( v[pivot >> 6u] >> ( pivot & 63u ) ) & 1u )
+      {
+        uint64_t const* basis_vector = &basis[r * num_blocks];
+        for ( auto b = 0u; b < num_blocks; ++b )
+        {
+          v[b] ^= basis_vector[b];
+        }
+      }
+    }
+  }
+
+private:
+  uint32_t num_blocks{0};
+  std::vector<uint64_t> basis;
+  std::vector<uint32_t> pivots;
+  std::vector<uint32_t> suffix_rank;
+  /* suffixes starting at `computed_first` or later are computed */
+  uint32_t computed_first{0};
+};
+
+} /* namespace detail */
+
 struct pattern_deps_analysis_params
 {
   bool select_first = false;
@@ -51,6 +200,12 @@ struct pattern_deps_analysis_params
   /* A value between 1u and 5u */
   uint32_t max_pattern_size{5};
 
+  /* Discard patterns that need more CNOTs than preparing the target without dependencies (see `compute_upperbound_cost`). */
+  bool use_upperbound = false;
+
+  /* Number of threads over which the target columns are distributed (0 uses all hardware threads). */
+  uint32_t num_threads{1};
+
   /* Be verbose. */
   bool verbose = true;
 }; /* dependency_analysis_params */
@@ -77,6 +232,9 @@ struct pattern_deps_analysis_stats
   uint32_t num_4tuples{0};
   uint32_t num_5tuples{0};
 
+  /* number of tuple prefixes that were not extended because no pattern can exist below them */
+  uint32_t num_pruned_subtrees{0};
+
   void report() const
   {
     fmt::print( "[i] total analysis time =        {:8.2f}s\n", to_seconds( total_time ) );
@@ -88,12 +246,34 @@ struct pattern_deps_analysis_stats
     fmt::print( "[i] computed patterns: {:8d} / {:8d}\n", num_patterns, num_analysed_patterns );
     fmt::print( "[i] iterations: {} singletons + {} pairs + {} triples + {} 4-tuples + {} 5-tuples\n",
                 num_singletons, num_2tuples, num_3tuples, num_4tuples, num_5tuples );
+    fmt::print( "[i] pruned subtrees: {}\n", num_pruned_subtrees );
   }
 
   void reset()
   {
     *this = {};
   }
+
+  /* accumulates the statistics of another (per-thread) analysis */
+  pattern_deps_analysis_stats& operator+=( pattern_deps_analysis_stats const& other )
+  {
+    total_time += other.total_time;
+    pattern1_time += other.pattern1_time;
+    pattern2_time += other.pattern2_time;
+    pattern3_time += other.pattern3_time;
+    pattern4_time += other.pattern4_time;
+    pattern5_time += other.pattern5_time;
+    num_analysed_patterns += other.num_analysed_patterns;
+    num_patterns += other.num_patterns;
+    num_constants += other.num_constants;
+    num_singletons += other.num_singletons;
+    num_2tuples += other.num_2tuples;
+    num_3tuples += other.num_3tuples;
+    num_4tuples += other.num_4tuples;
+    num_5tuples += other.num_5tuples;
+    num_pruned_subtrees += other.num_pruned_subtrees;
+    return *this;
+  }
 }; /* dependency_analysis_stats */
 
 struct pattern_deps_analysis_result_type
@@ -130,337 +310,566 @@ public:
   }
 
   pattern_deps_analysis_result_type run( function_type const& function )
+  {
+    return run( function, compute_column_matrix( function ) );
+  }
+
+  /*! \brief Runs the analysis on precomputed column vectors (see `compute_column_matrix`) */
+  pattern_deps_analysis_result_type run( function_type const& function, std::vector<kitty::partial_truth_table> const& column_matrix )
+  {
+    std::vector<uint32_t> targets( function.num_vars() );
+    std::iota( std::begin( targets ), std::end( targets ), 0u );
+    return run( function, column_matrix, targets );
+  }
+
+  /*! \brief Runs the analysis for some target variables only */
+  pattern_deps_analysis_result_type run( function_type const& function, std::vector<kitty::partial_truth_table> const& column_matrix, std::vector<uint32_t> const& target_indices )
+  {
+    return run( function, function_columns( column_matrix ), target_indices, ps.use_upperbound );
+  }
+
+  /*! \brief Runs the analysis for some target variables on prepared columns
+
+    Calls with the same prepared columns share the XOR bases, which are
+    extended when a target before the analysed ones is asked for.
+    `use_upperbound` is used instead of the parameter of the same name.
+  */
+  pattern_deps_analysis_result_type run( function_type const& function, function_columns const& prepared, std::vector<uint32_t> const& target_indices, bool use_upperbound )
   {
     stopwatch t( st.total_time );
 
-    /* create column vectors */
     uint32_t const num_vars = function.num_vars();
-    std::vector<dependency_analysis_types::column> columns{num_vars};
-    for ( auto i = 0u; i < columns.size(); ++i )
-    {
-      columns[i].index = i;
-    }
+    auto const& columns = prepared.columns;
+    auto const& complemented_columns = prepared.complemented_columns;
+    auto const& zero_lines = prepared.zero_lines;
+    auto const& one_lines = prepared.one_lines;
 
-    kitty::dynamic_truth_table minterm{function.num_vars()};
-    for ( auto const& m : kitty::get_minterms( function ) )
+    /* a target only uses the columns after it */
+    if ( !target_indices.empty() )
     {
-      minterm._bits[0] = m;
-      for ( auto i = 0; i < minterm.num_vars(); ++i )
+      uint32_t const first = *std::min_element( std::begin( target_indices ), std::end( target_indices ) ) + 1u;
+      if ( basis_id == prepared.id )
+      {
+        basis.extend( columns, first );
+      }
+      else
       {
-        columns[i].tt.add_bit( kitty::get_bit( minterm, i ) );
+        basis.compute( columns, first );
+        basis_id = prepared.id;
       }
     }
 
-    // for ( const auto& c : columns )
-    // {
-    //   kitty::print_binary( c.tt ); std::cout << std::endl;
-    // }
-
     pattern_deps_analysis_result_type result;
-    for ( auto i = 0u; i < num_vars; ++i )
+    std::vector<uint32_t> targets;
+    for ( auto const i : target_indices )
     {
-      /* collect patterns for i-th target column */
-      patterns.clear();
-
       /* skip constants */
       if ( kitty::is_const0( columns[i].tt ) )
       {
         result.dependencies[i] = std::make_pair( dependency_analysis_types::pattern_kind::CONST, std::vector<uint32_t>{ 0 } );
-        continue;
       }
-      else if ( kitty::is_const0( ~columns[i].tt ) )
+      else if ( kitty::is_const0( complemented_columns[i] ) )
       {
         result.dependencies[i] = std::make_pair( dependency_analysis_types::pattern_kind::CONST, std::vector<uint32_t>{ 1 } );
-        continue;
       }
-
-      bool success = false;
-      for ( auto j = i + 1u; j < num_vars; ++j )
+      else
       {
-        ++st.num_singletons;
-        success = call_with_stopwatch( st.pattern1_time, [&]() {
-          return check_unary_patterns( columns, i, j );
-        } );
-        if ( ps.select_first && success )
-          goto evaluate;
+        targets.emplace_back( i );
+      }
+    }
 
-        if ( ps.max_pattern_size < 2u )
-          continue;
+    /* analyse the targets independently, each worker picks the next unprocessed target */
+    std::vector<std::optional<dependency_analysis_types::pattern>> patterns( num_vars );
+    std::atomic<uint32_t> next_target{0u};
+    auto const analyse_targets = [&]( pattern_deps_analysis_stats& local_st ) {
+      target_analysis analysis( ps, local_st, basis );
+      for ( auto t = next_target++; t < targets.size(); t = next_target++ )
+      {
+        auto const i = targets[t];
+        auto const upper_bound = use_upperbound ? compute_upperbound_cost( zero_lines, one_lines, num_vars, i ) : std::numeric_limits<uint32_t>::max();
+        patterns[i] = analysis.run( columns, complemented_columns, i, upper_bound );
+      }
+    };
 
-        for ( auto k = j + 1u; k < num_vars; ++k )
-        {
-          ++st.num_2tuples;
-          success = call_with_stopwatch( st.pattern2_time, [&]() {
-            return check_nary_patterns( columns, i, {j, k} );
-          } );
-          if ( ps.select_first && success )
-            goto evaluate;
-
-          if ( ps.max_pattern_size < 3u )
-            continue;
-
-          for ( auto l = k + 1u; l < num_vars; ++l )
-          {
-            ++st.num_3tuples;
-            success = call_with_stopwatch( st.pattern3_time, [&]() {
-              return check_nary_patterns( columns, i, {j, k, l} );
-            } );
-            if ( ps.select_first && success )
-              goto evaluate;
-
-            if ( ps.max_pattern_size < 4u )
-              continue;
-
-            for ( auto m = l + 1u; m < num_vars; ++m )
-            {
-              ++st.num_4tuples;
-              success = call_with_stopwatch( st.pattern4_time, [&]() {
-                return check_nary_patterns( columns, i, {j, k, l, m} );
-              } );
-              if ( ps.select_first && success )
-                goto evaluate;
-
-              if ( ps.max_pattern_size < 5u )
-                continue;
-
-              for ( auto n = m + 1u; n < num_vars; ++n )
-              {
-                ++st.num_5tuples;
-                success = call_with_stopwatch( st.pattern5_time, [&]() {
-                  return check_nary_patterns( columns, i, {j, k, l, m, n} );
-                } );
-                if ( ps.select_first && success )
-                  goto evaluate;
-              }
-            }
-          }
-        }
+    uint32_t const num_threads = std::min<uint32_t>( ps.num_threads == 0u ? std::max( 1u, std::thread::hardware_concurrency() ) : ps.num_threads, targets.size() );
+    if ( num_threads <= 1u )
+    {
+      analyse_targets( st );
+    }
+    else
+    {
+      std::vector<pattern_deps_analysis_stats> thread_stats( num_threads );
+      std::vector<std::thread> threads;
+      for ( auto k = 0u; k < num_threads; ++k )
+      {
+        threads.emplace_back( [&, k]() { analyse_targets( thread_stats[k] ); } );
       }
+      for ( auto k = 0u; k < num_threads; ++k )
+      {
+        threads[k].join();
+        st += thread_stats[k];
+      }
+    }
 
-    evaluate:
-      /* evaluate patterns */
-      std::sort( std::begin( patterns ), std::end( patterns ),
-                 [&]( const auto& a, const auto& b ) {
-                   auto const cost_a = cost( a );
-                   auto const cost_b = cost( b );
-
-                   /* compare CNOTs */
-                   if ( cost_a.first < cost_b.first )
-                   {
-                     return true;
-                   }
-                   else if ( cost_a.first > cost_b.first )
-                   {
-                     return false;
-                   }
-
-                   /* compare NOTs */
-                   if ( cost_a.second < cost_b.second )
-                   {
-                     return true;
-                   }
-                   else if ( cost_a.second > cost_b.second )
-                   {
-                     return false;
-                   }
-
-                   /* when costs are equal, compare structurally to ensure a total order */
-                   if ( a.first < b.first )
-                   {
-                     return true;
-                   }
-                   else if ( a.first > b.first )
-                   {
-                     return false;
-                   }
-
-                   if ( a.second.size() < b.second.size() )
-                   {
-                     return true;
-                   }
-                   else if ( a.second.size() > b.second.size() )
-                   {
-                     return false;
-                   }
-
-                   for ( auto i = 0u; i < a.second.size(); ++i )
-                   {
-                     if ( a.second[i] < b.second[i] )
-                     {
-                       return true;
-                     }
-                   }
-
-                   return false;
-                 } );
-
-      // for ( const auto& p : patterns )
-      // {
-      //   std::cout << dependency_analysis_types::pattern_string( p ) << ' ' << cost( p ).first << ' ' << cost( p ).second << std::endl;
-      // }
-
-      /* update statistics and result */
-      if ( patterns.size() > 0u )
-      {
-        result.dependencies[i] = patterns[0u];
+    /* update statistics and result */
+    for ( auto i = 0u; i < num_vars; ++i )
+    {
+      if ( patterns[i] )
+      {
+        result.dependencies[i] = *patterns[i];
         ++st.num_patterns;
       }
-
-      st.num_analysed_patterns += patterns.size();
     }
 
     return result;
   }
 
 private:
-  std::pair<uint32_t, uint32_t> cost( dependency_analysis_types::pattern const& p ) const
+  /*! \brief Analysis of a single target column
+
+    Holds all scratch memory of the search such that each thread can use
+    its own instance.  The column vectors and the XOR bases are shared
+    and only read.
+  */
+  class target_analysis
   {
-    assert( p.second.size() > 0u );
-    switch ( p.first )
+  public:
+    explicit target_analysis( pattern_deps_analysis_params const& ps, pattern_deps_analysis_stats& st, detail::xor_suffix_basis const& basis )
+        : ps( ps ), st( st ), basis( basis )
     {
-    case dependency_analysis_types::pattern_kind::EQUAL:
+    }
+
+    /*! \brief Returns the cheapest pattern for the target that does not exceed `upper_bound` CNOTs */
+    std::optional<dependency_analysis_types::pattern> run( std::vector<dependency_analysis_types::column> const& columns, std::vector<kitty::partial_truth_table> const& complemented_columns,
+                                                           uint32_t target_index, uint32_t upper_bound )
     {
-      assert( p.second.size() == 1u );
-      return {1u, p.second[0] % 2u};
+      best.reset();
+      num_found = 0u;
+      this->upper_bound = upper_bound;
+
+      compute_polarities( columns, complemented_columns, target_index );
+      init_prefixes( columns, complemented_columns, target_index );
+      search( columns, complemented_columns, target_index, 1u );
+
+      st.num_analysed_patterns += num_found;
+      return best;
     }
-    case dependency_analysis_types::pattern_kind::XOR:
+
+  private:
+    std::pair<uint32_t, uint32_t> cost( dependency_analysis_types::pattern const& p ) const
     {
-      return {p.second.size(), 0u};
+      return pattern_cost( p );
     }
-    case dependency_analysis_types::pattern_kind::XNOR:
+
+    /*! \brief Total order on patterns: CNOTs, NOTs, and then structure */
+    bool is_better( dependency_analysis_types::pattern const& a, std::pair<uint32_t, uint32_t> const& cost_a,
+                    dependency_analysis_types::pattern const& b, std::pair<uint32_t, uint32_t> const& cost_b ) const
     {
-      return {p.second.size(), 1u};
+      if ( cost_a != cost_b )
+      {
+        return cost_a < cost_b;
+      }
+      if ( a.first != b.first )
+      {
+        return a.first < b.first;
+      }
+      if ( a.second.size() != b.second.size() )
+      {
+        return a.second.size() < b.second.size();
+      }
+      return std::lexicographical_compare( std::begin( a.second ), std::end( a.second ), std::begin( b.second ), std::end( b.second ) );
     }
-    case dependency_analysis_types::pattern_kind::AND:
+
+    /*! \brief Records a pattern and returns true if it does not exceed the upper bound */
+    bool add_pattern( dependency_analysis_types::pattern_kind kind, std::vector<uint32_t> fanins )
     {
-      auto const n = p.second.size();
-      auto polarity_counter = 0u;
-      for ( auto i = 0u; i < n; ++i )
+      ++num_found;
+
+      dependency_analysis_types::pattern p{kind, std::move( fanins )};
+      auto const c = cost( p );
+      if ( c.first > upper_bound )
       {
-        polarity_counter += 2u * ( p.second[i] % 2 );
+        return false;
       }
-      return {( 1u << n ), polarity_counter + ( 1u << n )};
+
+      if ( !best || is_better( p, c, *best, best_cost ) )
+      {
+        best = std::move( p );
+        best_cost = c;
+      }
+      return true;
     }
-    case dependency_analysis_types::pattern_kind::NAND:
+
+    /*! \brief Maximum number of CNOTs a new pattern may cost to be useful */
+    uint32_t cost_bound() const
     {
-      auto const n = p.second.size();
-      auto polarity_counter = 1u;
-      for ( auto i = 0u; i < n; ++i )
+      return best ? std::min( upper_bound, best_cost.first ) : upper_bound;
+    }
+
+    /*! \brief Enumerates the tuples of `size` columns that extend the current prefix
+
+      The columns `tuple[0], ..., tuple[size - 2]` form the prefix whose
+      partial XOR and AND products are stored at depth `size - 1`.
+      Returns true if the search can stop.
+    */
+    bool search( std::vector<dependency_analysis_types::column> const& columns, std::vector<kitty::partial_truth_table> const& complemented_columns,
+                 uint32_t target_index, uint32_t size )
+    {
+      uint32_t const num_vars = columns.size();
+      uint32_t const first = size == 1u ? target_index + 1u : tuple[size - 2u] + 1u;
+      for ( auto index = first; index < num_vars; ++index )
       {
-        polarity_counter += 2u * ( p.second[i] % 2 );
+        tuple[size - 1u] = index;
+
+        ++level_iterations( size );
+        auto const success = call_with_stopwatch( level_time( size ), [&]() {
+          return size == 1u ? check_unary_patterns( columns, complemented_columns, target_index, index )
+                            : check_nary_patterns( columns, complemented_columns, target_index, size );
+        } );
+        if ( ps.select_first && success )
+          return true;
+
+        if ( size >= std::min( ps.max_pattern_size, max_tuple_size ) )
+          continue;
+
+        if ( !extend_prefix( columns, complemented_columns, target_index, size ) )
+        {
+          ++st.num_pruned_subtrees;
+          continue;
+        }
+
+        if ( search( columns, complemented_columns, target_index, size + 1u ) )
+          return true;
       }
-      return {( 1u << n ), polarity_counter + ( 1u << n )};
+      return false;
     }
-    default:
-      std::abort();
+
+    uint32_t& level_iterations( uint32_t size )
+    {
+      switch ( size )
+      {
+      case 1u:
+        return st.num_singletons;
+      case 2u:
+        return st.num_2tuples;
+      case 3u:
+        return st.num_3tuples;
+      case 4u:
+        return st.num_4tuples;
+      default:
+        return st.num_5tuples;
+      }
     }
-  }
 
-  bool check_unary_patterns( std::vector<dependency_analysis_types::column> const& columns, uint32_t target_index, uint32_t other_index )
-  {
-    bool found = false;
-    if ( columns[target_index].tt == columns[other_index].tt )
+    stopwatch<>::duration_type& level_time( uint32_t size )
     {
-      patterns.emplace_back( dependency_analysis_types::pattern_kind::EQUAL, std::vector<uint32_t>{2u * other_index} );
-      found = true;
+      switch ( size )
+      {
+      case 1u:
+        return st.pattern1_time;
+      case 2u:
+        return st.pattern2_time;
+      case 3u:
+        return st.pattern3_time;
+      case 4u:
+        return st.pattern4_time;
+      default:
+        return st.pattern5_time;
+      }
     }
-    else if ( columns[target_index].tt == ~columns[other_index].tt )
+
+    bool check_unary_patterns( std::vector<dependency_analysis_types::column> const& columns, std::vector<kitty::partial_truth_table> const& complemented_columns,
+                               uint32_t target_index, uint32_t other_index )
     {
-      patterns.emplace_back( dependency_analysis_types::pattern_kind::EQUAL, std::vector<uint32_t>{2u * other_index + 1u} );
-      found = true;
+      uint64_t const* target = columns[target_index].tt._bits.data();
+
+      bool found = false;
+      if ( detail::is_equal( target, columns[other_index].tt._bits.data(), num_blocks ) )
+      {
+        found = add_pattern( dependency_analysis_types::pattern_kind::EQUAL, std::vector<uint32_t>{2u * other_index} );
+      }
+      else if ( detail::is_equal( target, complemented_columns[other_index]._bits.data(), num_blocks ) )
+      {
+        found = add_pattern( dependency_analysis_types::pattern_kind::EQUAL, std::vector<uint32_t>{2u * other_index + 1u} );
+      }
+      return found;
     }
-    return found;
-  }
 
-  bool check_nary_patterns( std::vector<dependency_analysis_types::column> const& columns, uint32_t target_index, std::vector<uint32_t> const& other_indices )
-  {
-    bool found = false;
+    /*! \brief Checks the patterns formed by the current prefix and `tuple[size - 1]`
 
-    /* xor */
-    if ( columns[target_index].tt == nary_xor( columns, other_indices ) )
+      Each check combines the partial product of the prefix with a single
+      column.
+    */
+    bool check_nary_patterns( std::vector<dependency_analysis_types::column> const& columns, std::vector<kitty::partial_truth_table> const& complemented_columns,
+                              uint32_t target_index, uint32_t size )
     {
-      std::vector<uint32_t> fanins( other_indices.size() );
-      for ( auto i = 0u; i < other_indices.size(); ++i )
+      /* XOR needs one CNOT per fanin and AND needs 2^k CNOTs */
+      if ( size > cost_bound() )
+      {
+        return false;
+      }
+
+      uint32_t const index = tuple[size - 1u];
+      uint64_t const* column = columns[index].tt._bits.data();
+
+      /* xor: the prefix already contains the target */
+      bool found = false;
+      if ( detail::is_equal( prefix_at( xor_prefix, size - 1u ), column, num_blocks ) )
+      {
+        found |= add_pattern( dependency_analysis_types::pattern_kind::XOR, make_fanins( size, 0u ) );
+      }
+      if ( detail::is_equal( prefix_at( xnor_prefix, size - 1u ), column, num_blocks ) )
+      {
+        found |= add_pattern( dependency_analysis_types::pattern_kind::XNOR, make_fanins( size, 0u ) );
+      }
+
+      if ( ( 1u << size ) > cost_bound() )
       {
-        fanins[i] = 2u * other_indices[i];
+        return found;
+      }
+
+      /* and (nand): the on-set (off-set) of the target implies the polarity of every fanin */
+      for ( auto const nand : {false, true} )
+      {
+        auto const& prefix_polarity = ( nand ? nand_prefix_polarity : and_prefix_polarity )[size - 1u];
+        auto const polarity = ( nand ? nand_polarity : and_polarity )[index];
+        if ( !prefix_polarity || polarity == no_polarity )
+        {
+          continue;
+        }
+
+        uint64_t const* operand = polarity ? complemented_columns[index]._bits.data() : column;
+        uint64_t const* target = nand ? complemented_columns[target_index]._bits.data() : columns[target_index].tt._bits.data();
+        if ( detail::and_equals( prefix_at( nand ? nand_prefix : and_prefix, size - 1u ), operand, target, num_blocks ) )
+        {
+          found |= add_pattern( nand ? dependency_analysis_types::pattern_kind::NAND : dependency_analysis_types::pattern_kind::AND,
+                                make_fanins( size, *prefix_polarity | ( uint32_t( polarity ) << ( size - 1u ) ) ) );
+        }
+      }
+      return found;
+    }
+
+    /*! \brief Computes the fanin polarities implied by the target and the rows they can exclude
+
+      A fanin of AND(l1, ..., lk) must be 1 in every row in which the
+      target is 1, which fixes its polarity; a column that is neither
+      contained in nor disjoint from the on-set of the target cannot be a
+      fanin.  The off-set of the target fixes the polarities of NAND
+      fanins in the same way.  `and_kill` (`nand_kill`) stores for every
+      column index `s` the rows that the compatible fanins `s, ..., n-1`
+      can still set to 0.
+    */
+    void compute_polarities( std::vector<dependency_analysis_types::column> const& columns, std::vector<kitty::partial_truth_table> const& complemented_columns, uint32_t target_index )
+    {
+      uint32_t const num_vars = columns.size();
+      uint32_t const num_blocks = columns[target_index].tt.num_blocks();
+      uint64_t const* target = columns[target_index].tt._bits.data();
+      uint64_t const* complemented_target = complemented_columns[target_index]._bits.data();
+
+      and_polarity.assign( num_vars, no_polarity );
+      nand_polarity.assign( num_vars, no_polarity );
+      and_kill.assign( ( num_vars + 1u ) * num_blocks, 0u );
+      nand_kill.assign( ( num_vars + 1u ) * num_blocks, 0u );
+
+      auto const update = [&]( uint64_t const* onset, std::vector<uint8_t>& polarities, std::vector<uint64_t>& kill, uint32_t index ) {
+        uint64_t const* column = columns[index].tt._bits.data();
+        uint64_t const* complemented_column = complemented_columns[index]._bits.data();
+        uint64_t const* killed = nullptr;
+        if ( detail::is_disjoint( onset, complemented_column, num_blocks ) )
+        {
+          polarities[index] = 0u;
+          killed = complemented_column;
+        }
+        else if ( detail::is_disjoint( onset, column, num_blocks ) )
+        {
+          polarities[index] = 1u;
+          killed = column;
+        }
+
+        for ( auto b = 0u; b < num_blocks; ++b )
+        {
+          kill[index * num_blocks + b] = kill[( index + 1u ) * num_blocks + b] | ( killed ? killed[b] : 0u );
+        }
+      };
+
+      for ( int32_t index = num_vars - 1; index > int32_t( target_index ); --index )
+      {
+        update( target, and_polarity, and_kill, index );
+        update( complemented_target, nand_polarity, nand_kill, index );
       }
-      patterns.emplace_back( dependency_analysis_types::pattern_kind::XOR, fanins );
-      found = true;
     }
-    if ( ~columns[target_index].tt == nary_xor( columns, other_indices ) )
+
+    /*! \brief Initializes the partial products of the empty prefix
+
+      The XOR prefixes start with the target (complemented target), such
+      that a tuple forms an XOR (XNOR) pattern if its last column equals
+      the prefix.  The AND prefixes start with all valid rows set.
+    */
+    void init_prefixes( std::vector<dependency_analysis_types::column> const& columns, std::vector<kitty::partial_truth_table> const& complemented_columns, uint32_t target_index )
     {
-      std::vector<uint32_t> fanins( other_indices.size() );
-      for ( auto i = 0u; i < other_indices.size(); ++i )
+      num_blocks = columns[target_index].tt.num_blocks();
+      residual.resize( num_blocks );
+      uint64_t const* target = columns[target_index].tt._bits.data();
+      uint64_t const* complemented_target = complemented_columns[target_index]._bits.data();
+
+      for ( auto* buffer : {&xor_prefix, &xnor_prefix, &and_prefix, &nand_prefix} )
+      {
+        buffer->resize( ( max_tuple_size + 1u ) * num_blocks );
+      }
+      for ( auto b = 0u; b < num_blocks; ++b )
       {
-        fanins[i] = 2u * other_indices[i];
+        xor_prefix[b] = target[b];
+        xnor_prefix[b] = complemented_target[b];
+        and_prefix[b] = nand_prefix[b] = target[b] | complemented_target[b];
       }
-      patterns.emplace_back( dependency_analysis_types::pattern_kind::XNOR, fanins );
-      found = true;
+      and_prefix_polarity[0u] = nand_prefix_polarity[0u] = 0u;
     }
 
-    /* and */
-    for ( uint32_t polarity = 0u; polarity < ( 1u << other_indices.size() ); ++polarity )
+    uint64_t* prefix_at( std::vector<uint64_t>& buffer, uint32_t depth )
     {
-      /* convert polarity to complement flags */
-      std::vector<bool> complement;
-      auto copy_polarity = polarity;
-      for ( auto i = 0u; i < other_indices.size(); ++i )
+      return &buffer[depth * num_blocks];
+    }
+
+    /*! \brief Extends the prefix with `tuple[size - 1]` and checks if it can be extended to a pattern
+
+      The XOR (XNOR) of the prefix and the target must differ by a
+      non-zero function that is spanned by the remaining columns.  For AND
+      (NAND), all fanins must have an implied polarity and the remaining
+      compatible columns must be able to clear all rows that the prefix
+      does not clear yet.
+    */
+    bool extend_prefix( std::vector<dependency_analysis_types::column> const& columns, std::vector<kitty::partial_truth_table> const& complemented_columns,
+                        uint32_t target_index, uint32_t size )
+    {
+      uint32_t const index = tuple[size - 1u];
+      uint32_t const next = index + 1u;
+      if ( next >= columns.size() )
+      {
+        return false;
+      }
+
+      /* no pattern with more fanins can beat the bound */
+      if ( size + 1u > cost_bound() )
       {
-        complement.push_back( ( copy_polarity & 1u ) );
-        copy_polarity >>= 1u;
+        return false;
       }
 
-      if ( columns[target_index].tt == nary_and( columns, other_indices, complement ) )
+      uint64_t const* column = columns[index].tt._bits.data();
+      bool viable = false;
+
+      /* xor and xnor */
+      for ( auto* buffer : {&xor_prefix, &xnor_prefix} )
       {
-        std::vector<uint32_t> fanins( other_indices.size() );
-        for ( auto i = 0u; i < other_indices.size(); ++i )
+        uint64_t const* from = prefix_at( *buffer, size - 1u );
+        uint64_t* to = prefix_at( *buffer, size );
+        for ( auto b = 0u; b < num_blocks; ++b )
         {
-          fanins[i] = 2u * other_indices[i] + complement[i];
+          to[b] = from[b] ^ column[b];
         }
-        patterns.emplace_back( dependency_analysis_types::pattern_kind::AND, fanins );
-        found = true;
+
+        /* if the prefix itself is a pattern, all extensions are more expensive */
+        if ( viable || detail::is_zero( to, num_blocks ) )
+        {
+          continue;
+        }
+        std::copy( to, to + num_blocks, residual.begin() );
+        basis.reduce( residual.data(), basis.rank( next ) );
+        viable = detail::is_zero( residual.data(), num_blocks );
       }
-      if ( columns[target_index].tt == ~nary_and( columns, other_indices, complement ) )
+
+      /* and and nand */
+      bool const and_in_bound = ( 1u << ( size + 1u ) ) <= cost_bound();
+      for ( auto const nand : {false, true} )
       {
-        std::vector<uint32_t> fanins( other_indices.size() );
-        for ( auto i = 0u; i < other_indices.size(); ++i )
+        auto& prefix_polarity = nand ? nand_prefix_polarity : and_prefix_polarity;
+        auto const polarity = ( nand ? nand_polarity : and_polarity )[index];
+        if ( !and_in_bound || !prefix_polarity[size - 1u] || polarity == no_polarity )
+        {
+          prefix_polarity[size] = std::nullopt;
+          continue;
+        }
+        prefix_polarity[size] = *prefix_polarity[size - 1u] | ( uint32_t( polarity ) << ( size - 1u ) );
+
+        auto& buffer = nand ? nand_prefix : and_prefix;
+        uint64_t const* from = prefix_at( buffer, size - 1u );
+        uint64_t* to = prefix_at( buffer, size );
+        uint64_t const* operand = polarity ? complemented_columns[index]._bits.data() : column;
+        for ( auto b = 0u; b < num_blocks; ++b )
+        {
+          to[b] = from[b] & operand[b];
+        }
+        if ( viable )
+        {
+          continue;
+        }
+
+        /* rows in which the prefix is 1 but the target is not */
+        uint64_t const* offset = nand ? columns[target_index].tt._bits.data() : complemented_columns[target_index]._bits.data();
+        uint64_t const* kill = &( nand ? nand_kill : and_kill )[next * num_blocks];
+        bool remaining = false;
+        bool coverable = true;
+        for ( auto b = 0u; b < num_blocks && coverable; ++b )
         {
-          fanins[i] = 2u * other_indices[i] + complement[i];
+          uint64_t const word = to[b] & offset[b];
+          remaining |= word != 0u;
+          coverable = ( word & ~kill[b] ) == 0u;
         }
-        patterns.emplace_back( dependency_analysis_types::pattern_kind::NAND, fanins );
-        found = true;
+        viable = remaining && coverable;
       }
-    }
-    return found;
-  }
 
-  kitty::partial_truth_table nary_and( std::vector<dependency_analysis_types::column> const& columns, std::vector<uint32_t> const& other_indices, std::vector<bool> const& complement )
-  {
-    /* compute nary and */
-    auto result = complement[0u] ? ~columns[other_indices[0u]].tt : columns[other_indices[0u]].tt;
-    for ( auto i = 1u; i < other_indices.size(); ++i )
-    {
-      result &= complement[i] ? ~columns[other_indices[i]].tt : columns[other_indices[i]].tt;
+      return viable;
     }
-    return result;
-  }
 
-  kitty::partial_truth_table nary_xor( std::vector<dependency_analysis_types::column> const& columns, std::vector<uint32_t> const& other_indices )
-  {
-    /* compute nary and */
-    auto result = columns[other_indices[0u]].tt;
-    for ( auto i = 1u; i < other_indices.size(); ++i )
+    std::vector<uint32_t> make_fanins( uint32_t size, uint32_t polarity ) const
     {
-      result ^= columns[other_indices[i]].tt;
+      std::vector<uint32_t> fanins;
+      fanins.reserve( size );
+      for ( auto i = 0u; i < size; ++i )
+      {
+        fanins.emplace_back( 2u * tuple[i] + ( polarity & 1u ) );
+        polarity >>= 1u;
+      }
+      return fanins;
     }
-    return result;
-  }
+
+  private:
+    pattern_deps_analysis_params const& ps;
+    pattern_deps_analysis_stats& st;
+    detail::xor_suffix_basis const& basis;
+
+    /* best pattern for the current target */
+    std::optional<dependency_analysis_types::pattern> best;
+    std::pair<uint32_t, uint32_t> best_cost;
+    uint32_t upper_bound;
+    uint32_t num_found;
+
+    /* implications used to prune the tuple search */
+    static constexpr uint8_t no_polarity = 2u;
+    std::vector<uint8_t> and_polarity;
+    std::vector<uint8_t> nand_polarity;
+    std::vector<uint64_t> and_kill;
+    std::vector<uint64_t> nand_kill;
+    std::vector<uint64_t> residual;
+
+    /* current tuple and the partial products of its prefixes, one row of `num_blocks` words per depth */
+    static constexpr uint32_t max_tuple_size = 5u;
+    uint32_t num_blocks;
+    std::array<uint32_t, max_tuple_size> tuple;
+    std::vector<uint64_t> xor_prefix;
+    std::vector<uint64_t> xnor_prefix;
+    std::vector<uint64_t> and_prefix;
+    std::vector<uint64_t> nand_prefix;
+    std::array<std::optional<uint32_t>, max_tuple_size + 1u> and_prefix_polarity;
+    std::array<std::optional<uint32_t>, max_tuple_size + 1u> nand_prefix_polarity;
+  };
 
 private:
   pattern_deps_analysis_params const& ps;
   pattern_deps_analysis_stats& st;
 
-  std::vector<dependency_analysis_types::pattern> patterns;
+  /* XOR bases of the prepared columns with id `basis_id` */
+  detail::xor_suffix_basis basis;
+  std::optional<uint64_t> basis_id;
 }; /* dependency_analysis_impl */
 
 } /* namespace angel */
@@ -0,0 +1,560 @@
+/* angel: C++ state preparation library
+ * Copyright (C) 2019-2020  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file sat_based_dependency_analysis.hpp
+
+  \brief Dependency analysis with SAT-based definability checks
+*/
+
+#pragma once
+
+#include "../quantum_state_preparation/utils.hpp"
+#include "../utils/helper_functions.hpp"
+#include "../utils/stopwatch.hpp"
+#include "common.hpp"
+#include "pattern_based_dependency_analysis.hpp"
+
+#include <bill/sat/solver.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/isop.hpp>
+#include <kitty/partial_truth_table.hpp>
+#include <mockturtle/algorithms/cnf.hpp>
+#include <mockturtle/networks/aig.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <set>
+#include <tuple>
+#include <vector>
+
+namespace angel
+{
+
+namespace detail
+{
+
+/*! \brief Creates a single-output AIG of a truth table from its irredundant SOP
+
+  Variable `i` of the truth table is the `i`-th primary input.
+*/
+inline mockturtle::aig_network aig_from_truth_table( kitty::dynamic_truth_table const& function )
+{
+  mockturtle::aig_network aig;
+  uint32_t const num_vars = function.num_vars();
+  std::vector<mockturtle::aig_network::signal> pis;
+  for ( auto i = 0u; i < num_vars; ++i )
+  {
+    pis.emplace_back( aig.create_pi() );
+  }
+
+  std::vector<mockturtle::aig_network::signal> products;
+  for ( auto const& cube : kitty::isop( function ) )
+  {
+    std::vector<mockturtle::aig_network::signal> literals;
+    for ( auto i = 0u; i < num_vars; ++i )
+    {
+      if ( cube.get_mask( i ) )
+      {
+        literals.emplace_back( cube.get_bit( i ) ? pis[i] : !pis[i] );
+      }
+    }
+    products.emplace_back( aig.create_nary_and( literals ) );
+  }
+  aig.create_po( aig.create_nary_or( products ) );
+  return aig;
+}
+
+} /* namespace detail */
+
+struct sat_deps_analysis_params
+{
+  /* Maximum number of fanins of a pattern. */
+  uint32_t max_pattern_size{5};
+
+  /* Maximum number of irredundant defining sets whose patterns are compared per target. */
+  uint32_t max_defining_sets{4};
+
+  /* Discard patterns that need more CNOTs than preparing the target without dependencies (see `compute_upperbound_cost`). */
+  bool use_upperbound = false;
+
+  /* Be verbose. */
+  bool verbose = false;
+}; /* sat_deps_analysis_params */
+
+struct sat_deps_analysis_stats
+{
+  stopwatch<>::duration_type total_time{0};
+  stopwatch<>::duration_type sat_time{0};
+
+  /* number of calls to the SAT solver */
+  uint32_t num_sat_calls{0};
+
+  /* number of targets that are defined by the variables with larger indices */
+  uint32_t num_defined_targets{0};
+
+  /* number of patterns return as result */
+  uint32_t num_patterns{0};
+
+  void report() const
+  {
+    fmt::print( "[i] total analysis time = {:8.2f}s\n", to_seconds( total_time ) );
+    fmt::print( "[i]   SAT solving =       {:8.2f}s ({} calls)\n", to_seconds( sat_time ), num_sat_calls );
+    fmt::print( "[i] computed patterns: {:8d} / {:8d} defined targets\n", num_patterns, num_defined_targets );
+  }
+
+  void reset()
+  {
+    *this = {};
+  }
+}; /* sat_deps_analysis_stats */
+
+/*! \brief Pattern-based dependency analysis with SAT-based definability checks
+
+  The on-set is given as a single-output AIG, whose CNF is instantiated
+  twice.  Target `x_i` is defined by a set `S` of variables iff
+
+    f(X) & f(X') & (X_S = X'_S) & x_i & ~x'_i
+
+  is unsatisfiable (Padoa's theorem).  Each equality `x_j = x'_j` is
+  guarded by an activation literal, such that all checks run
+  incrementally under assumptions.  Starting from all variables with
+  larger indices, the set is shrunk to the final conflict of the solver
+  and then to an irredundant set by removing one variable at a time.  If
+  the defining set is small enough, its defining function is computed by
+  cube enumeration and matched against the EQUAL, XOR, XNOR, AND, and
+  NAND patterns.
+
+  A target can have several irredundant defining sets, and the greedy
+  shrinking only finds one of them, which need not be the one with the
+  cheapest pattern.  Up to `max_defining_sets` sets are enumerated by
+  blocking each variable of a found set and shrinking again, and the
+  cheapest pattern over all of them is kept.  The enumeration is
+  bounded and not exhaustive, so a cheaper pattern on a set that is not
+  found can still be missed.
+
+  Variable `i` of the function is the `i`-th primary input of the AIG.
+*/
+class sat_deps_analysis
+{
+public:
+  using parameter_type = sat_deps_analysis_params;
+  using statistics_type = sat_deps_analysis_stats;
+  using result_type = pattern_deps_analysis_result_type;
+
+public:
+  using function_type = kitty::dynamic_truth_table;
+
+public:
+  explicit sat_deps_analysis( sat_deps_analysis_params const& ps, sat_deps_analysis_stats& st )
+      : ps( ps ), st( st )
+  {
+  }
+
+  pattern_deps_analysis_result_type run( function_type const& function )
+  {
+    return run( detail::aig_from_truth_table( function ) );
+  }
+
+  /*! \brief Runs the analysis on the truth table, constant variables are taken from the column vectors (see `compute_column_matrix`) */
+  pattern_deps_analysis_result_type run( function_type const& function, std::vector<kitty::partial_truth_table> const& column_matrix )
+  {
+    std::vector<uint32_t> targets( function.num_vars() );
+    std::iota( std::begin( targets ), std::end( targets ), 0u );
+    return run( function, column_matrix, targets );
+  }
+
+  /*! \brief Runs the analysis for some target variables only */
+  pattern_deps_analysis_result_type run( function_type const& function, std::vector<kitty::partial_truth_table> const& column_matrix, std::vector<uint32_t> const& targets )
+  {
+    return run( function, function_columns( column_matrix ), targets, ps.use_upperbound );
+  }
+
+  /*! \brief Runs the analysis for some target variables, constant variables are taken from the prepared columns
+
+    `use_upperbound` is used instead of the parameter of the same name.
+  */
+  pattern_deps_analysis_result_type run( function_type const& function, function_columns const& prepared, std::vector<uint32_t> const& targets, bool use_upperbound )
+  {
+    stopwatch t( st.total_time );
+
+    /* consecutive calls for the same function share the encoding */
+    if ( !encoded_function || *encoded_function != function )
+    {
+      num_vars = function.num_vars();
+      encode( detail::aig_from_truth_table( function ) );
+      encoded_function = function;
+    }
+
+    pattern_deps_analysis_result_type result;
+    analyse( targets, prepared.zero_lines, prepared.one_lines, use_upperbound, result );
+    return result;
+  }
+
+  /*! \brief Runs the analysis on an AIG with one primary output, the on-set */
+  pattern_deps_analysis_result_type run( mockturtle::aig_network const& aig )
+  {
+    stopwatch t( st.total_time );
+
+    assert( aig.num_pos() == 1u );
+    num_vars = aig.num_pis();
+    encode( aig );
+    encoded_function = std::nullopt;
+
+    pattern_deps_analysis_result_type result;
+
+    /* an empty on-set has constant columns only */
+    if ( solve( {} ) == bill::result::states::unsatisfiable )
+    {
+      for ( auto i = 0u; i < num_vars; ++i )
+      {
+        result.dependencies[i] = std::make_pair( dependency_analysis_types::pattern_kind::CONST, std::vector<uint32_t>{ 0 } );
+      }
+      return result;
+    }
+
+    std::vector<uint32_t> zero_lines, one_lines;
+    for ( auto i = 0u; i < num_vars; ++i )
+    {
+      if ( solve( {var( i, 0u )} ) == bill::result::states::unsatisfiable )
+      {
+        zero_lines.emplace_back( i );
+      }
+      else if ( solve( {~var( i, 0u )} ) == bill::result::states::unsatisfiable )
+      {
+        one_lines.emplace_back( i );
+      }
+    }
+
+    std::vector<uint32_t> targets( num_vars );
+    std::iota( std::begin( targets ), std::end( targets ), 0u );
+    analyse( targets, zero_lines, one_lines, ps.use_upperbound, result );
+    return result;
+  }
+
+private:
+  /*! \brief Adds the dependencies of `targets` to `result`, the on-set must be encoded */
+  void analyse( std::vector<uint32_t> const& targets, std::vector<uint32_t> const& zero_lines, std::vector<uint32_t> const& one_lines, bool use_upperbound, pattern_deps_analysis_result_type& result )
+  {
+    for ( auto const i : targets )
+    {
+      /* skip constants */
+      if ( std::find( std::begin( zero_lines ), std::end( zero_lines ), i ) != std::end( zero_lines ) )
+      {
+        result.dependencies[i] = std::make_pair( dependency_analysis_types::pattern_kind::CONST, std::vector<uint32_t>{ 0 } );
+        continue;
+      }
+      if ( std::find( std::begin( one_lines ), std::end( one_lines ), i ) != std::end( one_lines ) )
+      {
+        result.dependencies[i] = std::make_pair( dependency_analysis_types::pattern_kind::CONST, std::vector<uint32_t>{ 1 } );
+        continue;
+      }
+
+      auto const supports = defining_sets( i );
+      if ( supports.empty() )
+      {
+        continue;
+      }
+      ++st.num_defined_targets;
+
+      auto upper_bound = std::numeric_limits<uint32_t>::max();
+      if ( use_upperbound && num_vars - i - 1u < 32u )
+      {
+        upper_bound = compute_upperbound_cost( zero_lines, one_lines, num_vars, i );
+      }
+
+      std::optional<dependency_analysis_types::pattern> best;
+      for ( auto const& support : supports )
+      {
+        if ( support.empty() || support.size() > ps.max_pattern_size )
+        {
+          continue;
+        }
+
+        auto const p = match_patterns( i, support, upper_bound );
+        if ( p && ( !best || is_cheaper( *p, *best ) ) )
+        {
+          best = p;
+        }
+      }
+
+      if ( best )
+      {
+        result.dependencies[i] = *best;
+        ++st.num_patterns;
+      }
+    }
+  }
+
+  /*! \brief Encodes two copies of the on-set and the guarded equalities of their inputs */
+  void encode( mockturtle::aig_network const& aig )
+  {
+    solver.restart();
+
+    /* variable 0 is the constant, copy 1 uses the default node literals */
+    uint32_t const num_node_vars = 1u + aig.num_pis() + aig.num_gates();
+    auto const lits1 = mockturtle::node_literals( aig );
+    auto lits2 = mockturtle::node_literals( aig, num_node_vars + aig.num_pis() );
+    aig.foreach_pi( [&]( auto const& n, auto i ) {
+      lits2[n] = mockturtle::make_lit( num_node_vars + i );
+    } );
+    first_var2 = num_node_vars;
+    first_activation_var = num_node_vars + aig.num_pis() + aig.num_gates();
+    solver.add_variables( first_activation_var + aig.num_pis() );
+
+    auto const add_clause = [&]( std::vector<uint32_t> const& clause ) {
+      std::vector<bill::lit_type> lits;
+      for ( auto const& l : clause )
+      {
+        lits.emplace_back( l >> 1u, ( l & 1u ) ? bill::negative_polarity : bill::positive_polarity );
+      }
+      solver.add_clause( lits );
+    };
+    auto const outputs1 = mockturtle::generate_cnf<mockturtle::aig_network>( aig, add_clause, lits1 );
+    auto const outputs2 = mockturtle::generate_cnf<mockturtle::aig_network>( aig, add_clause, lits2 );
+    add_clause( std::vector<uint32_t>{outputs1[0u]} );
+    add_clause( std::vector<uint32_t>{outputs2[0u]} );
+
+    for ( auto j = 0u; j < aig.num_pis(); ++j )
+    {
+      solver.add_clause( {~activation( j ), ~var( j, 0u ), var( j, 1u )} );
+      solver.add_clause( {~activation( j ), var( j, 0u ), ~var( j, 1u )} );
+    }
+  }
+
+  bill::lit_type var( uint32_t index, uint32_t copy ) const
+  {
+    return bill::lit_type( copy == 0u ? index + 1u : first_var2 + index, bill::positive_polarity );
+  }
+
+  bill::lit_type activation( uint32_t index ) const
+  {
+    return bill::lit_type( first_activation_var + index, bill::positive_polarity );
+  }
+
+  bill::result::states solve( std::vector<bill::lit_type> const& assumptions )
+  {
+    ++st.num_sat_calls;
+    return call_with_stopwatch( st.sat_time, [&]() {
+      return solver.solve( assumptions );
+    } );
+  }
+
+  /*! \brief Checks if the variables in `support` define target `i` */
+  bool is_defined_by( uint32_t i, std::vector<uint32_t> const& support )
+  {
+    std::vector<bill::lit_type> assumptions{var( i, 0u ), ~var( i, 1u )};
+    for ( auto const j : support )
+    {
+      assumptions.emplace_back( activation( j ) );
+    }
+    return solve( assumptions ) == bill::result::states::unsatisfiable;
+  }
+
+  /*! \brief Returns up to `ps.max_defining_sets` irredundant sets of variables with larger indices that define target `i`
+
+    The result is empty if target `i` is not defined.  Each found set is
+    expanded by excluding one more of its variables from the candidates,
+    such that the next search must find a different set.
+  */
+  std::vector<std::vector<uint32_t>> defining_sets( uint32_t i )
+  {
+    std::vector<std::vector<uint32_t>> supports;
+    /* breadth-first over the sets of excluded variables, starting with none */
+    std::set<std::vector<uint32_t>> visited;
+    std::deque<std::vector<uint32_t>> excluded_sets( 1u );
+    while ( !excluded_sets.empty() && supports.size() < ps.max_defining_sets )
+    {
+      auto const excluded = excluded_sets.front();
+      excluded_sets.pop_front();
+
+      std::vector<uint32_t> candidate;
+      for ( auto j = i + 1u; j < num_vars; ++j )
+      {
+        if ( !std::binary_search( std::begin( excluded ), std::end( excluded ), j ) )
+        {
+          candidate.emplace_back( j );
+        }
+      }
+      if ( !is_defined_by( i, candidate ) )
+      {
+        continue;
+      }
+
+      auto const support = irredundant_defining_set( i );
+      if ( std::find( std::begin( supports ), std::end( supports ), support ) != std::end( supports ) )
+      {
+        continue;
+      }
+      supports.emplace_back( support );
+
+      for ( auto const j : support )
+      {
+        auto next = excluded;
+        next.insert( std::upper_bound( std::begin( next ), std::end( next ), j ), j );
+        if ( visited.insert( next ).second )
+        {
+          excluded_sets.emplace_back( next );
+        }
+      }
+    }
+    return supports;
+  }
+
+  /*! \brief Shrinks the set of the last successful check `is_defined_by( i, ... )` to an irredundant one */
+  std::vector<uint32_t> irredundant_defining_set( uint32_t i )
+  {
+    /* keep the activation literals in the final conflict */
+    auto const core = solver.get_core().core();
+    std::vector<uint32_t> support;
+    for ( auto const& lit : core )
+    {
+      if ( lit.variable() >= first_activation_var )
+      {
+        support.emplace_back( lit.variable() - first_activation_var );
+      }
+    }
+    std::sort( std::begin( support ), std::end( support ) );
+
+    /* remove variables with larger indices first, such that ties keep smaller ones */
+    for ( auto k = int32_t( support.size() ) - 1; k >= 0; --k )
+    {
+      auto candidate = support;
+      candidate.erase( std::begin( candidate ) + k );
+      if ( is_defined_by( i, candidate ) )
+      {
+        support = candidate;
+      }
+    }
+    return support;
+  }
+
+  /*! \brief Checks if pattern `p` is cheaper than `q`, in the same order as `pattern_deps_analysis`: CNOTs, NOTs, and then structure */
+  static bool is_cheaper( dependency_analysis_types::pattern const& p, dependency_analysis_types::pattern const& q )
+  {
+    return std::make_tuple( pattern_cost( p ), p.first, p.second.size(), p.second ) < std::make_tuple( pattern_cost( q ), q.first, q.second.size(), q.second );
+  }
+
+  /*! \brief Computes the defining function of target `i` on `support` and matches it against patterns */
+  std::optional<dependency_analysis_types::pattern> match_patterns( uint32_t i, std::vector<uint32_t> const& support, uint32_t upper_bound )
+  {
+    using kind = dependency_analysis_types::pattern_kind;
+
+    /* cube enumeration: minterm `m` assigns bit `b` to `support[b]` */
+    uint32_t const k = support.size();
+    std::vector<uint32_t> on, off;
+    for ( auto m = 0u; m < ( 1u << k ); ++m )
+    {
+      std::vector<bill::lit_type> assumptions;
+      for ( auto b = 0u; b < k; ++b )
+      {
+        assumptions.emplace_back( ( ( m >> b ) & 1u ) ? var( support[b], 0u ) : ~var( support[b], 0u ) );
+      }
+      if ( solve( assumptions ) != bill::result::states::satisfiable )
+      {
+        continue;
+      }
+      auto const model = solver.get_model().model();
+      ( model.at( var( i, 0u ).variable() ) == bill::lbool_type::true_ ? on : off ).emplace_back( m );
+    }
+
+    std::optional<dependency_analysis_types::pattern> best;
+    auto const add_pattern = [&]( kind pattern_kind, std::vector<uint32_t> const& fanins ) {
+      dependency_analysis_types::pattern p{pattern_kind, fanins};
+      if ( pattern_cost( p ).first > upper_bound )
+      {
+        return;
+      }
+
+      if ( !best || is_cheaper( p, *best ) )
+      {
+        best = std::move( p );
+      }
+    };
+
+    auto const parity = []( uint32_t m ) { return __builtin_popcount( m ) & 1u; };
+    auto const all_of = []( std::vector<uint32_t> const& ms, auto&& pred ) { return std::all_of( std::begin( ms ), std::end( ms ), pred ); };
+
+    std::vector<uint32_t> fanins;
+    if ( all_of( on, [&]( auto m ) { return parity( m ) == 1u; } ) && all_of( off, [&]( auto m ) { return parity( m ) == 0u; } ) )
+    {
+      for ( auto const j : support )
+      {
+        fanins.emplace_back( 2u * j );
+      }
+      add_pattern( k == 1u ? kind::EQUAL : kind::XOR, fanins );
+    }
+    else if ( all_of( on, [&]( auto m ) { return parity( m ) == 0u; } ) && all_of( off, [&]( auto m ) { return parity( m ) == 1u; } ) )
+    {
+      for ( auto const j : support )
+      {
+        fanins.emplace_back( 2u * j + ( k == 1u ? 1u : 0u ) );
+      }
+      add_pattern( k == 1u ? kind::EQUAL : kind::XNOR, fanins );
+    }
+
+    /* the only minterm of an AND (NAND) pattern is the on-set (off-set) */
+    if ( k >= 2u )
+    {
+      for ( auto const nand : {false, true} )
+      {
+        auto const& implying = nand ? off : on;
+        auto const& other = nand ? on : off;
+        if ( !all_of( implying, [&]( auto m ) { return m == implying[0u]; } ) ||
+             std::find( std::begin( other ), std::end( other ), implying[0u] ) != std::end( other ) )
+        {
+          continue;
+        }
+
+        fanins.clear();
+        for ( auto b = 0u; b < k; ++b )
+        {
+          fanins.emplace_back( 2u * support[b] + ( ( ( implying[0u] >> b ) & 1u ) ? 0u : 1u ) );
+        }
+        add_pattern( nand ? kind::NAND : kind::AND, fanins );
+      }
+    }
+
+    return best;
+  }
+
+private:
+  sat_deps_analysis_params const& ps;
+  sat_deps_analysis_stats& st;
+
+  bill::solver<bill::solvers::glucose_41> solver;
+  std::optional<function_type> encoded_function;
+  uint32_t num_vars{0};
+  uint32_t first_var2{0};
+  uint32_t first_activation_var{0};
+};
+
+} /* namespace angel */
@@ -1,9 +1,14 @@
 /* Author: Fereshte */
 #pragma once
+#include <angel/utils/bdd_from_truth_table.hpp>
 #include <angel/utils/stopwatch.hpp>
 #include <cplusplus/cuddObj.hh>
 #include <cudd/cudd.h>
 #include <cudd/cuddInt.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <map>
 #include <tweedledum/algorithms/synthesis/linear_synth.hpp>
@@ -12,7 +17,6 @@
 #include <tweedledum/gates/io3_gate.hpp>
 #include <tweedledum/gates/mcmt_gate.hpp>
 #include <tweedledum/networks/io_id.hpp>
-#include <unordered_set>
 #include "utils.hpp"
 #include <kitty/kitty.hpp>
 #include <angel/utils/helper_functions.hpp>
@@ -49,17 +53,17 @@ struct create_bdd_param
 
 namespace detail
 {
-BDD create_bdd_from_pla( Cudd& cudd, std::string file_name, uint32_t& num_inputs )
+inline BDD create_bdd_from_pla( Cudd& cudd, std::string file_name, uint32_t& num_inputs )
 {
   std::ifstream infile( file_name );
   std::string in, out;
   infile >> in >> out;
   num_inputs = std::atoi( out.c_str() );
   BDD output;
-  auto bddNodes = new BDD[num_inputs];
-  for ( int i = num_inputs - 1; i >= 0; i-- )
+  std::vector<BDD> bddNodes( num_inputs );
+  for ( auto i = 0u; i < num_inputs; ++i )
   {
-    bddNodes[i] = cudd.bddVar(); // index 0: LSB
+    bddNodes[i] = cudd.bddVar( num_inputs - 1 - i ); // index 0: LSB
   }
 
   bool sig = 1;
@@ -96,56 +100,41 @@ BDD create_bdd_from_pla( Cudd& cudd, std::string file_name, uint32_t& num_inputs
   return output;
 }
 
-BDD create_bdd_from_tt_str( Cudd& cudd, std::string tt_str, uint32_t num_inputs )
+/*! \brief Creates the BDD of a truth table with one `ite` per Shannon node
+
+  Variable `i` of the truth table is the BDD variable with index
+  `num_vars - 1 - i`, such that the most significant variable is at the
+  top of the BDD (see `create_bdd_from_truth_table`).
+*/
+inline BDD create_bdd_from_tt( Cudd& cudd, kitty::dynamic_truth_table const& tt )
 {
-  //std::ifstream infile( file_name );
-  //std::string tt_str;
-  //infile >> tt_str;
-  
-  auto bddNodes = new BDD[num_inputs];
-  for ( int i = num_inputs - 1; i >= 0; i-- )
+  /* create all variables, also those the function does not depend on */
+  uint32_t const num_vars = tt.num_vars();
+  for ( auto i = 0u; i < num_vars; ++i )
   {
-    bddNodes[i] = cudd.bddVar(); // index 0: LSB
+    cudd.bddVar( i );
   }
 
-  BDD f_bdd;
-  int sig = 1;
+  std::vector<BDD> vars;
+  for ( auto i = 0u; i < num_vars; ++i )
+  {
+    vars.emplace_back( cudd.bddVar( num_vars - 1 - i ) );
+  }
+  return create_bdd_from_truth_table( cudd, tt, vars );
+}
 
+inline BDD create_bdd_from_tt_str( Cudd& cudd, std::string tt_str, uint32_t num_inputs )
+{
   /* 
     zero index in tt_str consist the bigest minterm of tt 
     so we read it from last element
   */
-  
-  for ( auto i = 0u; i <tt_str.size() ; i++ )
-  {
-    if ( tt_str[tt_str.size()-i-1] == '1' )
-    {
-      auto n = i;
-      BDD temp;
-      temp = ( ( n & 1 ) == 1 ) ? bddNodes[0] : !bddNodes[0];
-      n >>= 1;
-      for ( auto j = 1u; j < num_inputs; j++ )
-      {
-        temp &= ( ( n & 1 ) == 1 ) ? bddNodes[j] : !bddNodes[j];
-        n >>= 1;
-      }
-
-      if ( sig )
-      {
-        f_bdd = temp;
-        sig = 0;
-      }
-      else
-      {
-        f_bdd |= temp;
-      }
-    }
-  }
-
-  return f_bdd;
+  kitty::dynamic_truth_table tt( num_inputs );
+  kitty::create_from_binary_string( tt, tt_str );
+  return create_bdd_from_tt( cudd, tt );
 }
 
-BDD create_bdd( Cudd& cudd, std::string str, create_bdd_param bdd_param, uint32_t& num_inputs )
+inline BDD create_bdd( Cudd& cudd, std::string str, create_bdd_param bdd_param, uint32_t& num_inputs )
 {
   BDD bdd;
   if ( bdd_param.strategy == create_bdd_param::strategy::create_from_tt )
@@ -156,413 +145,318 @@ BDD create_bdd( Cudd& cudd, std::string str, create_bdd_param bdd_param, uint32_
   return bdd;
 }
 
-void draw_dump( DdNode* f_add, DdManager* mgr )
+inline void draw_dump( DdNode* f, DdManager* mgr )
 {
   FILE* outfile; /* output file pointer for .dot file */
   outfile = fopen( "graph.dot", "w" );
-  DdNode** ddnodearray = (DdNode**)malloc( sizeof( DdNode* ) ); /* initialize the function array */
-  ddnodearray[0] = f_add;
+  if ( outfile == nullptr )
+    return;
+  DdNode* ddnodearray[1] = {f}; /* initialize the function array */
   Cudd_DumpDot( mgr, 1, ddnodearray, NULL, NULL, outfile ); /* dump the function to .dot file */
+  fclose( outfile );
 }
 
-void count_ones_bdd_nodes( std::unordered_set<DdNode*>& visited,
-                           std::vector<std::map<DdNode*, uint32_t>>& node_ones,
-                           DdNode* f, uint32_t num_vars, std::vector<uint32_t> orders )
+/*! \brief BDD below a root as dense arrays in post-order, with the number of ones of each node
+
+  Node `i` is a regular node with variable `index[i]`, children come
+  before their parents.  An edge is `2 * position + complement`, where
+  the complement is pushed to the children, the constant one has the
+  position `constant_position`, and the constant zero is its complement.
+  `children[i]` holds the else and then edge of node `i`, and `ones[i]`
+  its number of ones over the variables `index[i], ..., num_vars - 1`.
+  A node is not constant, so its count is less than 2^64 if at most 64
+  variables are below it.  Only for BDDs over more variables, the counts
+  of all nodes are also kept as doubles in `large_ones`, which are used
+  for the nodes with more than 64 variables below them.
+*/
+struct bdd_node_ones
 {
-  auto current = f;
-  if ( visited.count( current ) )
-    return;
-  if ( Cudd_IsConstant( current ) )
-    return;
+  static constexpr uint32_t constant_position = 0x7fffffffu;
+  static constexpr uint32_t const1_edge = 2u * constant_position;
+  static constexpr uint32_t const0_edge = const1_edge + 1u;
 
-  count_ones_bdd_nodes( visited, node_ones, cuddE( current ), num_vars, orders );
-  count_ones_bdd_nodes( visited, node_ones, cuddT( current ), num_vars, orders );
-
-  visited.insert( current );
-  uint32_t Eones = 0;
-  uint32_t Tones = 0;
-
-  if ( Cudd_IsConstant( cuddT( current ) ) )
-  {
-    if ( Cudd_V( cuddT( current ) ) )
-    {
-      auto temp_pow = num_vars - orders[current->index] - 1;
-      Tones = pow( 2, temp_pow ) * 1;
-    }
-  }
-  else
+  static bool is_constant( uint32_t edge )
   {
-    auto temp_pow = orders[cuddT( current )->index] - 1 - orders[current->index];
-    auto Tvalue = 0;
-    Tvalue = node_ones[cuddT( current )->index].find( cuddT( current ) )->second;
-    Tones = pow( 2, temp_pow ) * Tvalue;
+    return ( edge >> 1u ) == constant_position;
   }
 
-  if ( Cudd_IsConstant( cuddE( current ) ) )
-  {
-    if ( Cudd_V( cuddE( current ) ) )
-    {
-      auto temp_pow = num_vars - orders[current->index] - 1;
-      Eones = pow( 2, temp_pow ) * 1;
-    }
-  }
-  else
-  {
-    auto temp_pow = orders[cuddE( current )->index] - 1 - orders[current->index];
-    //auto max_ones = pow( 2, num_vars - orders[cuddE( current )->index] );
-    auto Evalue = 0;
-    Evalue = node_ones[cuddE( current )->index].find( cuddE( current ) )->second;
-    Eones = pow( 2, temp_pow ) * Evalue;
-  }
+  uint32_t root{const0_edge};
+  std::vector<uint32_t> index;
+  std::vector<std::array<uint32_t, 2u>> children;
+  std::vector<uint64_t> ones;
+  std::vector<double> large_ones;
+};
 
-  node_ones[current->index].insert( {current, Tones + Eones} );
-}
+/*! \brief Number of ones of the function at edge `edge` over the variables `level, ..., num_vars - 1`
 
-void count_ones_bdd_nodes( std::unordered_set<DdNode*>& visited,
-                           std::vector<std::map<DdNode*, uint32_t>>& node_ones,
-                           DdNode* f, uint32_t num_vars )
+  Counts are stored for regular nodes only, a complemented edge has the
+  ones of the subcube below its node that the regular node does not have.
+  The complement is taken on the exact count, where 2^64 wraps to 0.
+*/
+inline double edge_ones( bdd_node_ones const& node_ones, uint32_t edge, uint32_t num_vars, uint32_t level )
 {
-  auto current = f;
-  if ( visited.count( current ) )
-    return;
-  if ( Cudd_IsConstant( current ) )
-    return;
-
-  count_ones_bdd_nodes( visited, node_ones, cuddE( current ), num_vars );
-  count_ones_bdd_nodes( visited, node_ones, cuddT( current ), num_vars );
-
-  visited.insert( current );
-  uint32_t Eones = 0;
-  uint32_t Tones = 0;
-
-  if ( Cudd_IsConstant( cuddT( current ) ) )
-  {
-    if ( Cudd_V( cuddT( current ) ) )
-    {
-      auto temp_pow = num_vars - current->index - 1;
-      Tones = pow( 2, temp_pow ) * 1;
-    }
-  }
-  else
+  if ( bdd_node_ones::is_constant( edge ) )
   {
-    auto temp_pow = cuddT( current )->index - 1 - current->index;
-    auto Tvalue = 0;
-    Tvalue = node_ones[cuddT( current )->index].find( cuddT( current ) )->second;
-    Tones = pow( 2, temp_pow ) * Tvalue;
+    return edge == bdd_node_ones::const1_edge ? std::ldexp( 1.0, num_vars - level ) : 0.0;
   }
 
-  if ( Cudd_IsConstant( cuddE( current ) ) )
+  auto const position = edge >> 1u;
+  auto const index = node_ones.index[position];
+  uint32_t const num_below = num_vars - index;
+  if ( num_below > 64u )
   {
-    if ( Cudd_V( cuddE( current ) ) )
-    {
-      auto temp_pow = num_vars - current->index - 1;
-      Eones = pow( 2, temp_pow ) * 1;
-    }
+    auto const ones = node_ones.large_ones[position];
+    return std::ldexp( ( edge & 1u ) ? std::ldexp( 1.0, num_below ) - ones : ones, index - level );
   }
-  else
+
+  auto ones = node_ones.ones[position];
+  if ( edge & 1u )
   {
-    auto temp_pow = cuddE( current )->index - 1 - current->index;
-    //auto max_ones = pow( 2, num_vars - orders[cuddE( current )->index] );
-    auto Evalue = 0;
-    Evalue = node_ones[cuddE( current )->index].find( cuddE( current ) )->second;
-    Eones = pow( 2, temp_pow ) * Evalue;
+    ones = ( num_below == 64u ? uint64_t( 0 ) : uint64_t( 1 ) << num_below ) - ones;
   }
-
-  node_ones[current->index].insert( {current, Tones + Eones} );
+  return std::ldexp( static_cast<double>( ones ), index - level );
 }
 
-void extract_probabilities_and_MCgates( std::unordered_set<DdNode*>& visited,
-                                        std::vector<std::map<DdNode*, uint32_t>> node_ones,
-                                        std::map<DdNode*, std::vector<std::vector<std::pair<double, std::vector<int32_t>>>>>& gates,
-                                        DdNode* f, uint32_t num_vars, std::vector<uint32_t> orders )
+/*! \brief Exact number of ones of the function at edge `edge` over the variables `level, ..., num_vars - 1`, at most 63 of them */
+inline uint64_t exact_edge_ones( bdd_node_ones const& node_ones, uint32_t edge, uint32_t num_vars, uint32_t level )
 {
-  /* gates construction
-  std::map<DdNode*, std::vector<std::vector<std::pair<double, std::vector<int32_t>>>>>
-  map -> for each node
-  std::vector<std::vector<std::pair<double, std::vector<int32_t>>>>
-  vector1 -> include all qubits
-  vector2 -> gates for each qubit
-  inner vector -> controls
-  */
-  auto current = f;
-  if ( visited.count( current ) )
-    return;
-  if ( Cudd_IsConstant( current ) )
-    return;
-
-  extract_probabilities_and_MCgates( visited, node_ones, gates, cuddE( current ), num_vars, orders );
-  extract_probabilities_and_MCgates( visited, node_ones, gates, cuddT( current ), num_vars, orders );
-
-  visited.insert( current );
-  double ep = 0.0;
-  double dp = node_ones[current->index].find( current )->second;
-  if ( Cudd_IsConstant( cuddT( current ) ) && Cudd_V( cuddT( current ) ) ) //?? ->  probability
-  {
-    ep = pow( 2, num_vars - 1 - current->index ); //ep = pow( 2, num_vars - 1 - orders[current->index] );
-  }
-  else if ( Cudd_IsConstant( cuddT( current ) ) && !Cudd_V( cuddT( current ) ) ) //?? ->  probability
-  {
-    ep = 0;
-  }
-  else
+  if ( bdd_node_ones::is_constant( edge ) )
   {
-    ep = node_ones[cuddT( current )->index].find( cuddT( current ) )->second *
-         ( pow( 2, cuddT( current )->index - current->index - 1 ) ); //?? ->  probability // ( pow( 2, orders[cuddT( current )->index] - orders[current->index] - 1 ) ); 
+    return edge == bdd_node_ones::const1_edge ? uint64_t( 1 ) << ( num_vars - level ) : 0u;
   }
 
-  double p = ep / dp; /* one probability */
-
-  auto const it = gates.find( current );
-  if ( it == gates.end() )
+  auto const position = edge >> 1u;
+  auto const index = node_ones.index[position];
+  auto ones = node_ones.ones[position];
+  if ( edge & 1u )
   {
-    gates.emplace( current, std::vector<std::vector<std::pair<double, std::vector<int32_t>>>>( num_vars ) );
+    ones = ( uint64_t( 1 ) << ( num_vars - index ) ) - ones;
   }
+  return ones << ( index - level );
+}
 
-  /* inserting current single-qubit G(p) gate */
-  if ( p != 0 )
-  {
-    gates[current][current->index].emplace_back( std::make_pair<double, std::vector<int32_t>>( 1 - p, {} ) );
-    //std::cout << "index: " << current->index << std::endl;
-  }
+/*! \brief Counts the ones of all nodes below `f` in one iterative post-order pass
 
-  /* inserting childs gates */
-  if ( !Cudd_IsConstant( cuddE( current ) ) )
-  {
-    for ( auto i = 0u; i < num_vars; i++ )
-    {
-      if ( gates[cuddE( current )][i].size() != 0 )
-      {
-        for ( auto j = 0u; j < gates[cuddE( current )][i].size(); j++ )
-        {
-          auto pro = gates[cuddE( current )][i][j].first;
-          std::vector<int32_t> controls;
-          for ( auto k = 0u; k < gates[cuddE( current )][i][j].second.size(); k++ )
-            controls.emplace_back( gates[cuddE( current )][i][j].second[k] );
-          //std::copy(gates[cuddE(current)][i][j].second.begin() , gates[cuddE(current)][i][j].second.end() , controls);
-          //auto controls = gates[cuddE(current)][i][j].second;
-          if ( p != 0 && p != 1 )
-          {
-            //std::cout << "p: " << p << std::endl;
-            controls.emplace_back( -( current->index + 1 ) );
-          }
-
-          gates[current][i].emplace_back( std::make_pair( pro, controls ) );
-        }
-      }
-    }
-  }
+  While the nodes are collected, the `next` field of a visited node holds
+  its position tagged with the complement bit, in the same way as CUDD
+  marks visited nodes in `Cudd_DagSize`.  No hash table is needed to find
+  the position of a child, and the fields are restored before returning.
+*/
+inline bdd_node_ones count_ones_bdd_nodes( DdNode* f, uint32_t num_vars )
+{
+  bdd_node_ones node_ones;
 
-  if ( !Cudd_IsConstant( cuddT( current ) ) )
+  /* visited nodes with their original `next` field */
+  struct marked_nodes
   {
-    for ( auto i = 0u; i < num_vars; i++ )
+    std::vector<std::pair<DdNode*, DdNode*>> nodes;
+    ~marked_nodes()
     {
-      if ( gates[cuddT( current )][i].size() != 0 )
+      for ( auto const& [node, next] : nodes )
       {
-        for ( auto j = 0u; j < gates[cuddT( current )][i].size(); j++ )
-        {
-          auto pro = gates[cuddT( current )][i][j].first;
-          std::vector<int32_t> controls;
-          for ( auto k = 0u; k < gates[cuddT( current )][i][j].second.size(); k++ )
-            controls.emplace_back( gates[cuddT( current )][i][j].second[k] );
-          //std::copy(gates[cuddT(current)][i][j].second.begin() , gates[cuddT(current)][i][j].second.end() , controls);
-
-          //auto controls = gates[cuddT(current)][i][j].second;
-          if ( p != 0 && p != 1 )
-            controls.emplace_back( current->index + 1 );
-          gates[current][i].emplace_back( std::make_pair( pro, controls ) );
-        }
+        node->next = next;
       }
     }
-  }
+  } marked;
+
+  auto const is_visited = []( DdNode* node ) {
+    return ( reinterpret_cast<std::uintptr_t>( node->next ) & 1u ) != 0u;
+  };
+  auto const edge_of = []( DdNode* e ) {
+    auto const node = Cudd_Regular( e );
+    auto const position = Cudd_IsConstant( node ) ? bdd_node_ones::constant_position : static_cast<uint32_t>( reinterpret_cast<std::uintptr_t>( node->next ) >> 1u );
+    return 2u * position + ( Cudd_IsComplement( e ) ? 1u : 0u );
+  };
+
+  /* a node is pushed twice, to expand its children and, once they are counted, to count it */
+  std::vector<std::pair<DdNode*, bool>> stack;
+  stack.emplace_back( Cudd_Regular( f ), false );
+  while ( !stack.empty() )
+  {
+    auto const [current, expanded] = stack.back();
+    stack.pop_back();
+    if ( Cudd_IsConstant( current ) || is_visited( current ) )
+      continue;
 
-  /* inserting Hadamard gates */
-  auto Edown = Cudd_IsConstant( cuddE( current ) ) ? num_vars : cuddE( current )->index; //orders[cuddE( current )->index];
-  auto Tdown = Cudd_IsConstant( cuddT( current ) ) ? num_vars : cuddT( current )->index; //orders[cuddT( current )->index];
-  uint32_t E_num_value = 1;
-  uint32_t T_num_value = 1;
-  if ( Cudd_IsConstant( cuddE( current ) ) && !Cudd_V( cuddE( current ) ) )
-    E_num_value = 0;
-  if ( Cudd_IsConstant( cuddT( current ) ) && !Cudd_V( cuddT( current ) ) )
-    T_num_value = 0;
-  for ( auto i = current->index + 1; i < Edown; i++ ) //orders[current->index] + 1
-  {
-    //auto id = std::find( orders.begin(), orders.end(), i ) - orders.begin();
-    if ( E_num_value != 0 )
+    if ( !expanded )
     {
-      //gates_pre[id].insert({current, std::make_tuple( 1/2.0, nullptr , nullptr ) });
-      std::vector<int32_t> temp_c;
-      if ( p != 0 && p != 1 )
-        temp_c.emplace_back( -( current->index + 1 ) );
-      gates[current][i].emplace_back( std::make_pair( 1 / 2.0, temp_c ) ); // id -> i
+      stack.emplace_back( current, true );
+      stack.emplace_back( Cudd_Regular( cuddT( current ) ), false );
+      stack.emplace_back( Cudd_Regular( cuddE( current ) ), false );
+      continue;
     }
-  }
-  for ( auto i = current->index + 1; i < Tdown; i++ ) //orders[current->index] + 1;
-  {
-    //auto id = std::find( orders.begin(), orders.end(), i ) - orders.begin();
-    if ( T_num_value != 0 )
+
+    auto const position = static_cast<uint32_t>( node_ones.ones.size() );
+    std::array<uint32_t, 2u> const children{edge_of( cuddE( current ) ), edge_of( cuddT( current ) )};
+    /* the exact count does not fit if more than 64 variables are below the node */
+    auto const level = current->index + 1;
+    node_ones.ones.push_back( num_vars - current->index > 64u ? 0u : exact_edge_ones( node_ones, children[1], num_vars, level ) + exact_edge_ones( node_ones, children[0], num_vars, level ) );
+    if ( num_vars > 64u )
     {
-      //gates_pre[id].insert({current, std::make_tuple( 1/2.0, nullptr , nullptr ) });
-      std::vector<int32_t> temp_c;
-      if ( p != 0 && p != 1 )
-        temp_c.emplace_back( current->index + 1 );
-      gates[current][i].emplace_back( std::make_pair( 1 / 2.0, temp_c ) ); //id -> i
+      node_ones.large_ones.push_back( edge_ones( node_ones, children[1], num_vars, level ) + edge_ones( node_ones, children[0], num_vars, level ) );
     }
+    node_ones.index.push_back( current->index );
+    node_ones.children.push_back( children );
+
+    marked.nodes.emplace_back( current, current->next );
+    current->next = reinterpret_cast<DdNode*>( ( std::uintptr_t( position ) << 1u ) | 1u );
   }
+
+  node_ones.root = edge_of( f );
+  return node_ones;
 }
 
-void extract_probabilities_and_MCgates( std::unordered_set<DdNode*>& visited,
-                                        std::vector<std::map<DdNode*, uint32_t>> node_ones,
-                                        std::map<DdNode*, std::vector<std::vector<std::pair<double, std::vector<int32_t>>>>>& gates,
-                                        DdNode* f, uint32_t num_vars)
+/*! \brief Gates of the function at one BDD edge
+
+  The gates of a function are its own G(p) gate on qubit `index`, the
+  gates of its two cofactors, and Hadamard gates on the qubits skipped by
+  the cofactor edges.  The gates of a cofactor are referenced by the
+  position of its group and get the control literal of their branch only
+  when the groups are flattened, such that the groups are linear in the
+  size of the BDD.
+*/
+struct gate_group
+{
+  struct branch
+  {
+    /* control literal of the branch, 0 if it is not controlled */
+    int32_t control{0};
+    /* position of the cofactor group, -1 for constant cofactors */
+    int32_t child{-1};
+    /* Hadamard gates on the qubits `hadamard_begin, ..., hadamard_end - 1` */
+    uint32_t hadamard_begin{0};
+    uint32_t hadamard_end{0};
+  };
+
+  uint32_t index;
+  /* probability of the G(p) gate, only if `has_rotation` */
+  double probability;
+  bool has_rotation;
+  /* else and then branch */
+  branch branches[2];
+};
+
+/* for each qubit, the gates as pairs of probability and controls */
+using qsp_bdd_gates = std::vector<std::vector<std::pair<double, std::vector<int32_t>>>>;
+
+inline uint32_t extract_probabilities_and_MCgates( std::vector<int32_t>& group_of,
+                                                   bdd_node_ones const& node_ones,
+                                                   std::vector<gate_group>& groups,
+                                                   uint32_t f, uint32_t num_vars )
 {
-  /* gates construction
-  std::map<DdNode*, std::vector<std::vector<std::pair<double, std::vector<int32_t>>>>>
-  map -> for each node
-  std::vector<std::vector<std::pair<double, std::vector<int32_t>>>>
-  vector1 -> include all qubits
-  vector2 -> gates for each qubit
-  inner vector -> controls
-  */
   auto current = f;
-  if ( visited.count( current ) )
-    return;
-  if ( Cudd_IsConstant( current ) )
-    return;
+  if ( group_of[current] != -1 )
+    return group_of[current];
 
-  extract_probabilities_and_MCgates( visited, node_ones, gates, cuddE( current ), num_vars );
-  extract_probabilities_and_MCgates( visited, node_ones, gates, cuddT( current ), num_vars );
+  auto const position = current >> 1u;
+  auto const index = node_ones.index[position];
+  uint32_t const children[2] = {node_ones.children[position][0] ^ ( current & 1u ), node_ones.children[position][1] ^ ( current & 1u )};
 
-  visited.insert( current );
-  double ep = 0.0;
-  double dp = node_ones[current->index].find( current )->second;
-  if ( Cudd_IsConstant( cuddT( current ) ) && Cudd_V( cuddT( current ) ) ) //?? ->  probability
+  int32_t child_groups[2] = {-1, -1};
+  for ( auto b = 0u; b < 2u; ++b )
   {
-    ep = pow( 2, num_vars - 1 - current->index ); //ep = pow( 2, num_vars - 1 - orders[current->index] );
-  }
-  else if ( Cudd_IsConstant( cuddT( current ) ) && !Cudd_V( cuddT( current ) ) ) //?? ->  probability
-  {
-    ep = 0;
-  }
-  else
-  {
-    ep = node_ones[cuddT( current )->index].find( cuddT( current ) )->second *
-         ( pow( 2, cuddT( current )->index - current->index - 1 ) ); //?? ->  probability // ( pow( 2, orders[cuddT( current )->index] - orders[current->index] - 1 ) ); 
+    if ( !bdd_node_ones::is_constant( children[b] ) )
+    {
+      child_groups[b] = extract_probabilities_and_MCgates( group_of, node_ones, groups, children[b], num_vars );
+    }
   }
 
+  double dp = edge_ones( node_ones, current, num_vars, index );
+  double ep = edge_ones( node_ones, children[1], num_vars, index + 1 ); /* one probability */
+
   double p = ep / dp; /* one probability */
 
-  auto const it = gates.find( current );
-  if ( it == gates.end() )
+  gate_group group;
+  group.index = index;
+  group.probability = 1 - p;
+  group.has_rotation = p != 0;
+  for ( auto b = 0u; b < 2u; ++b )
   {
-    gates.emplace( current, std::vector<std::vector<std::pair<double, std::vector<int32_t>>>>( num_vars ) );
+    auto& branch = group.branches[b];
+    if ( p != 0 && p != 1 )
+    {
+      branch.control = b ? index + 1 : -( index + 1 );
+    }
+    branch.child = child_groups[b];
+
+    /* Hadamard gates on the qubits skipped by the branch */
+    if ( children[b] != bdd_node_ones::const0_edge )
+    {
+      branch.hadamard_begin = index + 1;
+      branch.hadamard_end = bdd_node_ones::is_constant( children[b] ) ? num_vars : node_ones.index[children[b] >> 1u];
+    }
   }
 
+  groups.push_back( group );
+  group_of[current] = groups.size() - 1;
+  return groups.size() - 1;
+}
+
+/*! \brief Expands the gates of a group under the controls of the path that leads to it
+
+  The controls are ordered from the innermost to the outermost literal.
+*/
+inline void flatten_gate_groups( std::vector<gate_group> const& groups, uint32_t position,
+                                 std::vector<int32_t>& path, qsp_bdd_gates& gates )
+{
+  auto const& group = groups[position];
+  auto const add_gate = [&]( uint32_t qubit, double probability, int32_t control ) {
+    std::vector<int32_t> controls;
+    if ( control != 0 )
+      controls.emplace_back( control );
+    controls.insert( controls.end(), path.rbegin(), path.rend() );
+    gates[qubit].emplace_back( probability, controls );
+  };
+
   /* inserting current single-qubit G(p) gate */
-  if ( p != 0 )
+  if ( group.has_rotation )
   {
-    gates[current][current->index].emplace_back( std::make_pair<double, std::vector<int32_t>>( 1 - p, {} ) );
-    //std::cout << "index: " << current->index << std::endl;
+    add_gate( group.index, group.probability, 0 );
   }
 
   /* inserting childs gates */
-  if ( !Cudd_IsConstant( cuddE( current ) ) )
-  {
-    for ( auto i = 0u; i < num_vars; i++ )
-    {
-      if ( gates[cuddE( current )][i].size() != 0 )
-      {
-        for ( auto j = 0u; j < gates[cuddE( current )][i].size(); j++ )
-        {
-          auto pro = gates[cuddE( current )][i][j].first;
-          std::vector<int32_t> controls;
-          for ( auto k = 0u; k < gates[cuddE( current )][i][j].second.size(); k++ )
-            controls.emplace_back( gates[cuddE( current )][i][j].second[k] );
-          //std::copy(gates[cuddE(current)][i][j].second.begin() , gates[cuddE(current)][i][j].second.end() , controls);
-          //auto controls = gates[cuddE(current)][i][j].second;
-          if ( p != 0 && p != 1 )
-          {
-            //std::cout << "p: " << p << std::endl;
-            controls.emplace_back( -( current->index + 1 ) );
-          }
-
-          gates[current][i].emplace_back( std::make_pair( pro, controls ) );
-        }
-      }
-    }
-  }
-
-  if ( !Cudd_IsConstant( cuddT( current ) ) )
+  for ( auto const& branch : group.branches )
   {
-    for ( auto i = 0u; i < num_vars; i++ )
-    {
-      if ( gates[cuddT( current )][i].size() != 0 )
-      {
-        for ( auto j = 0u; j < gates[cuddT( current )][i].size(); j++ )
-        {
-          auto pro = gates[cuddT( current )][i][j].first;
-          std::vector<int32_t> controls;
-          for ( auto k = 0u; k < gates[cuddT( current )][i][j].second.size(); k++ )
-            controls.emplace_back( gates[cuddT( current )][i][j].second[k] );
-          //std::copy(gates[cuddT(current)][i][j].second.begin() , gates[cuddT(current)][i][j].second.end() , controls);
-
-          //auto controls = gates[cuddT(current)][i][j].second;
-          if ( p != 0 && p != 1 )
-            controls.emplace_back( current->index + 1 );
-          gates[current][i].emplace_back( std::make_pair( pro, controls ) );
-        }
-      }
-    }
+    if ( branch.child == -1 )
+      continue;
+    if ( branch.control != 0 )
+      path.push_back( branch.control );
+    flatten_gate_groups( groups, branch.child, path, gates );
+    if ( branch.control != 0 )
+      path.pop_back();
   }
 
   /* inserting Hadamard gates */
-  auto Edown = Cudd_IsConstant( cuddE( current ) ) ? num_vars : cuddE( current )->index; //orders[cuddE( current )->index];
-  auto Tdown = Cudd_IsConstant( cuddT( current ) ) ? num_vars : cuddT( current )->index; //orders[cuddT( current )->index];
-  uint32_t E_num_value = 1;
-  uint32_t T_num_value = 1;
-  if ( Cudd_IsConstant( cuddE( current ) ) && !Cudd_V( cuddE( current ) ) )
-    E_num_value = 0;
-  if ( Cudd_IsConstant( cuddT( current ) ) && !Cudd_V( cuddT( current ) ) )
-    T_num_value = 0;
-  for ( auto i = current->index + 1; i < Edown; i++ ) //orders[current->index] + 1
-  {
-    //auto id = std::find( orders.begin(), orders.end(), i ) - orders.begin();
-    if ( E_num_value != 0 )
-    {
-      //gates_pre[id].insert({current, std::make_tuple( 1/2.0, nullptr , nullptr ) });
-      std::vector<int32_t> temp_c;
-      if ( p != 0 && p != 1 )
-        temp_c.emplace_back( -( current->index + 1 ) );
-      gates[current][i].emplace_back( std::make_pair( 1 / 2.0, temp_c ) ); // id -> i
-    }
-  }
-  for ( auto i = current->index + 1; i < Tdown; i++ ) //orders[current->index] + 1;
+  for ( auto const& branch : group.branches )
   {
-    //auto id = std::find( orders.begin(), orders.end(), i ) - orders.begin();
-    if ( T_num_value != 0 )
+    for ( auto i = branch.hadamard_begin; i < branch.hadamard_end; ++i )
     {
-      //gates_pre[id].insert({current, std::make_tuple( 1/2.0, nullptr , nullptr ) });
-      std::vector<int32_t> temp_c;
-      if ( p != 0 && p != 1 )
-        temp_c.emplace_back( current->index + 1 );
-      gates[current][i].emplace_back( std::make_pair( 1 / 2.0, temp_c ) ); //id -> i
+      add_gate( i, 1 / 2.0, branch.control );
     }
   }
 }
 
-void extract_quantum_gates( DdNode* f_add, uint32_t num_inputs, std::vector<uint32_t> orders,
-                            std::map<DdNode*, std::vector<std::vector<std::pair<double, std::vector<int32_t>>>>>& gates )
+/*! \brief Extracts the gates for the state of `f`, returns the number of gate groups */
+inline uint32_t extract_quantum_gates( DdNode* f, uint32_t num_inputs, qsp_bdd_gates& gates )
 {
-  std::vector<std::map<DdNode*, uint32_t>> node_ones( num_inputs );
-  //std::vector<std::pair<uint32_t, uint32_t>> ones_frac;
-  std::unordered_set<DdNode*> visited;
-  std::unordered_set<DdNode*> visited1;
-  count_ones_bdd_nodes( visited, node_ones, f_add, num_inputs );
-  extract_probabilities_and_MCgates( visited1, node_ones, gates, f_add, num_inputs );
+  auto const node_ones = count_ones_bdd_nodes( f, num_inputs );
+
+  if ( bdd_node_ones::is_constant( node_ones.root ) )
+    return 0u;
+
+  /* group of each edge, -1 if it has not been extracted yet */
+  std::vector<int32_t> group_of( 2u * node_ones.ones.size(), -1 );
+  std::vector<gate_group> groups;
+  auto const root = extract_probabilities_and_MCgates( group_of, node_ones, groups, node_ones.root, num_inputs );
+
+  gates.resize( num_inputs );
+  std::vector<int32_t> path;
+  flatten_gate_groups( groups, root, path, gates );
+  return groups.size();
 }
 
-void extract_statistics( Cudd cudd, DdNode* f_add,
-                         std::map<DdNode*, std::vector<std::vector<std::pair<double, std::vector<int32_t>>>>> gates,
-                         qsp_bdd_statistics& stats, std::vector<uint32_t> orders )
+inline void extract_statistics( qsp_bdd_gates const& gates,
+                                qsp_bdd_statistics& stats, std::vector<uint32_t> const& orders )
 {
   auto total_MC_gates = 0u;
   auto Rxs = 0;
@@ -571,24 +465,24 @@ void extract_statistics( Cudd cudd, DdNode* f_add,
   auto CNOTs = 0;
   auto Ancillaes = 0;
 
-  for ( auto i = 0; i < cudd.ReadSize(); i++ )
+  for ( auto i = 0u; i < orders.size(); i++ )
   {
     
-    if(gates[f_add].size()==0)
+    if(gates.size()==0)
       break;
-    total_MC_gates += gates[f_add][orders[i]].size();
+    total_MC_gates += gates[orders[i]].size();
     
     
-    if ( gates[f_add][orders[i]].size() == 0 )
+    if ( gates[orders[i]].size() == 0 )
       continue;
     
     auto max_cs = 0u;
     std::vector< std::vector<int32_t> > MCs;
-    for ( auto j = 0u; j < gates[f_add][orders[i]].size(); j++ )
+    for ( auto j = 0u; j < gates[orders[i]].size(); j++ )
     {
-      if(gates[f_add][orders[i]][j].second.size()>0)
-        MCs.emplace_back(gates[f_add][orders[i]][j].second);
-      //auto cs = gates[f_add][i][j].second.size();
+      if(gates[orders[i]][j].second.size()>0)
+        MCs.emplace_back(gates[orders[i]][j].second);
+      //auto cs = gates[i][j].second.size();
       //if ( cs > max_cs )
         //max_cs = cs;
     }
@@ -599,7 +493,7 @@ void extract_statistics( Cudd cudd, DdNode* f_add,
     {
       Rys += 1;
     }
-    else if ( max_cs == 1 && gates[f_add][orders[i]].size() == 1 && gates[f_add][orders[i]][0].first == 0 )
+    else if ( max_cs == 1 && gates[orders[i]].size() == 1 && gates[orders[i]][0].first == 0 )
     {
       CNOTs += 1;
     }
@@ -620,6 +514,123 @@ void extract_statistics( Cudd cudd, DdNode* f_add,
 } // namespace detail
 //**************************************************************
 
+struct qsp_bdd_engine_params
+{
+  /* initial number of slots per subtable of the unique table */
+  uint32_t unique_slots{CUDD_UNIQUE_SLOTS};
+  /* initial number of slots of the computed table */
+  uint32_t cache_slots{CUDD_CACHE_SLOTS};
+  /* maximum number of entries of the computed table (0: CUDD's default) */
+  uint32_t max_cache_hard{0};
+  /* target maximum memory of the manager in bytes (0: CUDD's default) */
+  uint64_t max_memory{0};
+  /* number of prepared states between two garbage collections (0: only on demand) */
+  uint32_t batch_size{0};
+  /* write the BDD of every state to graph.dot in the working directory */
+  bool dump_bdd{false};
+  create_bdd_param bdd_param;
+};
+
+/**
+ * \brief Quantum State Preparation using Decision Diagram with one long-lived CUDD manager
+ *
+ * The manager, its variables, its unique table, and its computed table are
+ * shared by all states prepared with the engine, such that preparing many
+ * small states does not set up and tear down a manager every time.  Nodes
+ * of earlier states are collected every `batch_size` states or on
+ * `collect_garbage`.
+*/
+class qsp_bdd_engine
+{
+public:
+  explicit qsp_bdd_engine( qsp_bdd_engine_params const& ps = {} )
+    : ps( ps )
+    , cudd( 0u, 0u, ps.unique_slots, ps.cache_slots, ps.max_memory )
+  {
+    if ( ps.max_cache_hard != 0u )
+    {
+      cudd.SetMaxCacheHard( ps.max_cache_hard );
+    }
+  }
+
+  /**
+   * \param network the extracted quantum circuit for given quantum state
+   * \param str include desired quantum state for preparation in tt or pla version
+   * \param stats store all desired statistics of quantum state preparation process
+  */
+  template<class Network>
+  void operator()( Network& network, std::string const& str, qsp_bdd_statistics& stats )
+  {
+    (void)network;
+
+    uint32_t num_inputs = log2( str.size() );
+    auto const from_tt = ps.bdd_param.strategy == create_bdd_param::strategy::create_from_tt;
+
+    /* Create BDD */
+    BDD f_bdd;
+    if ( !from_tt )
+    {
+      f_bdd = detail::create_bdd( cudd, str, ps.bdd_param, num_inputs );
+    }
+
+    /* reordering tt */
+    std::vector<uint32_t> orders;
+    for ( int32_t i = num_inputs - 1; i >= 0; i-- )
+      orders.emplace_back( i );
+
+    if ( from_tt )
+    {
+      kitty::dynamic_truth_table tt( num_inputs );
+      kitty::create_from_binary_string( tt, str );
+      reordering_on_tt_inplace( tt, orders );
+      f_bdd = detail::create_bdd_from_tt( cudd, tt );
+    }
+    auto f = f_bdd.getNode();
+
+    /* draw bdd in a output file */
+    if ( ps.dump_bdd )
+    {
+      detail::draw_dump( f, cudd.getManager() );
+    }
+
+    /* Generate quantum gates by traversing BDD */
+    detail::qsp_bdd_gates gates;
+    uint32_t num_groups{0};
+
+    stopwatch<>::duration_type time_bdd_traversal{0};
+    {
+      stopwatch t( time_bdd_traversal );
+      num_groups = detail::extract_quantum_gates( f, num_inputs, gates );
+    }
+
+    /* extract statistics */
+    stats.nodes += num_groups; // one group per non-constant function, i.e., per node of the equivalent ADD
+    stats.time += to_seconds( time_bdd_traversal );
+    detail::extract_statistics( gates, stats, orders );
+
+    if ( ps.batch_size != 0u && ++num_states % ps.batch_size == 0u )
+    {
+      collect_garbage();
+    }
+  }
+
+  /*! \brief Frees the nodes of earlier states and their entries in the computed table */
+  void collect_garbage()
+  {
+    cuddGarbageCollect( cudd.getManager(), 1 );
+  }
+
+  Cudd& manager()
+  {
+    return cudd;
+  }
+
+private:
+  qsp_bdd_engine_params const ps;
+  Cudd cudd;
+  uint64_t num_states{0};
+};
+
 /**
  * \breif Quantum State Preparation using Decision Diagram
  * 
@@ -632,54 +643,10 @@ void extract_statistics( Cudd cudd, DdNode* f_add,
 template<class Network>
 void qsp_bdd( Network& network, std::string str, qsp_bdd_statistics& stats, create_bdd_param param = {} )
 {
-  uint32_t num_inputs = log2(str.size());
-  /* reordering tt */
-  std::vector<uint32_t> orders;
-  for ( int32_t i = num_inputs-1; i >=0; i-- )
-    orders.emplace_back( i );
-
-    // orders.emplace_back( 0 );
-    // orders.emplace_back( 2 );
-    // orders.emplace_back( 1 );
-    // orders.emplace_back( 3 );
-  //std::cout<<orders[0]<<" "<<orders[1]<<" "<<orders[2]<<" "<<orders[3]<<std::endl;
-  kitty::dynamic_truth_table tt(num_inputs);
-  kitty::create_from_binary_string(tt, str);
-  reordering_on_tt_inplace(tt, orders);
-  str = kitty::to_binary(tt);
-  //std::cout<<str<<std::endl;
-  /* Create BDD */
-  Cudd cudd;
-  auto mgr = cudd.getManager();
-  auto f_bdd = detail::create_bdd( cudd, str, param, num_inputs );
-  
-  //auto f_bdd = detail::create_bdd_from_tt_str( cudd, str, num_inputs );
-  auto f_add = Cudd_BddToAdd( mgr, f_bdd.getNode() );
-
-  /* 
-    BDD help sample 
-    auto d = mgr.bddVar(); //MSB
-    auto c = mgr.bddVar(); //LSB
-  */
-
-  /* draw add in a output file */
-  detail::draw_dump( f_add, mgr );
-  
-  /* Generate quantum gates by traversing ADD */
-  
-  std::map<DdNode*, std::vector<std::vector<std::pair<double, std::vector<int32_t>>>>> gates;
-
-  stopwatch<>::duration_type time_add_traversal{0};
-  {
-    stopwatch t( time_add_traversal );
-    detail::extract_quantum_gates( f_add, num_inputs, orders, gates );
-  }
-
-  /* extract statistics */
-  stats.nodes += Cudd_DagSize( f_add ) - 2; // it consider 2 nodes for "0" and "1"
-  stats.time += to_seconds( time_add_traversal );
-  detail::extract_statistics( cudd, f_add, gates, stats, orders );
-  
+  qsp_bdd_engine_params ps;
+  ps.bdd_param = param;
+  qsp_bdd_engine engine( ps );
+  engine( network, str, stats );
 }
 
 } // namespace angel
@@ -10,8 +10,12 @@
 #include <kitty/hash.hpp>
 #include <fmt/format.h>
 
+#include <cassert>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <numeric>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
@@ -22,6 +26,64 @@ using esop_based_dependencies_t = std::map<uint32_t, std::vector<std::vector<uin
 using gates_t = std::map<uint32_t, std::vector<std::pair<double, std::vector<uint32_t>>>>;
 using order_t = std::vector<uint32_t>;
 
+/*! \brief Dependencies that are computed when gate generation first asks for them
+
+  `find( i )` calls `compute( i )` the first time target `i` is looked
+  up and remembers the result, such that the dependency analysis only
+  runs for targets that are reached in the recursion.
+*/
+template<typename Dependencies>
+class lazy_dependencies
+{
+public:
+  using mapped_type = typename Dependencies::mapped_type;
+  using compute_function = std::function<std::optional<mapped_type>( uint32_t )>;
+
+public:
+  explicit lazy_dependencies( uint32_t num_vars, compute_function const& compute )
+    : computed( num_vars, false )
+    , compute( compute )
+  {
+  }
+
+  typename Dependencies::iterator find( uint32_t index )
+  {
+    if ( !computed[index] )
+    {
+      computed[index] = true;
+      if ( auto const dependency = compute( index ) )
+      {
+        dependencies.emplace( index, *dependency );
+      }
+    }
+    return dependencies.find( index );
+  }
+
+  typename Dependencies::iterator end()
+  {
+    return dependencies.end();
+  }
+
+  /*! \brief Dependency of a target that has one */
+  mapped_type& operator[]( uint32_t index )
+  {
+    auto const it = find( index );
+    assert( it != end() );
+    return it->second;
+  }
+
+  /*! \brief Dependencies of the targets that have been looked up so far */
+  Dependencies const& computed_dependencies() const
+  {
+    return dependencies;
+  }
+
+private:
+  std::vector<bool> computed;
+  compute_function compute;
+  Dependencies dependencies;
+};
+
 // std::string const filename1 = fmt::format("qsp_cut_functions_ISCAS_8.txt");
 // std::ofstream ofs( filename1 );
 
@@ -92,7 +154,7 @@ struct qsp_general_stats
 
 /* with esop based dependencies */
 void MC_qg_generation( gates_t& gates, uint32_t num_vars, kitty::dynamic_truth_table tt, uint32_t var_index, std::vector<uint32_t> controls,
-                       esop_based_dependencies_t dependencies, std::vector<uint32_t> zero_lines, std::vector<uint32_t> one_lines )
+                       lazy_dependencies<esop_based_dependencies_t>& dependencies, std::vector<uint32_t> zero_lines, std::vector<uint32_t> one_lines )
 {
   /*-----co factors-------*/
   kitty::dynamic_truth_table tt0( var_index );
@@ -160,14 +222,14 @@ void MC_qg_generation( gates_t& gates, uint32_t num_vars, kitty::dynamic_truth_t
 
   std::vector<uint32_t> controls_new0;
   std::copy( controls.begin(), controls.end(), back_inserter( controls_new0 ) );
-  if ( dependencies.find( var_index ) == dependencies.end() && !is_const )
+  if ( !is_const && dependencies.find( var_index ) == dependencies.end() )
   {
     auto ctrl0 = var_index * 2 + 1; /* negetive control: /2 ---> index %2 ---> sign */
     controls_new0.emplace_back( ctrl0 );
   }
   std::vector<uint32_t> controls_new1;
   std::copy( controls.begin(), controls.end(), back_inserter( controls_new1 ) );
-  if ( dependencies.find( var_index ) == dependencies.end() && !is_const )
+  if ( !is_const && dependencies.find( var_index ) == dependencies.end() )
   {
     auto ctrl1 = var_index * 2 + 0; /* positive control: /2 ---> index %2 ---> sign */
     controls_new1.emplace_back( ctrl1 );
@@ -235,7 +297,7 @@ void MC_qg_generation( gates_t& gates, uint32_t num_vars, kitty::dynamic_truth_t
 
 /* with pattern based dependencies */
 void MC_qg_generation( gates_t& gates, uint32_t num_vars, kitty::dynamic_truth_table tt, uint32_t var_index, std::vector<uint32_t> controls,
-                       pattern_based_dependencies_t dependencies, std::vector<uint32_t> zero_lines, std::vector<uint32_t> one_lines )
+                       lazy_dependencies<pattern_based_dependencies_t>& dependencies, std::vector<uint32_t> zero_lines, std::vector<uint32_t> one_lines )
 {
   /*-----co factors-------*/
   kitty::dynamic_truth_table tt0( var_index );
@@ -331,14 +393,14 @@ void MC_qg_generation( gates_t& gates, uint32_t num_vars, kitty::dynamic_truth_t
 
   std::vector<uint32_t> controls_new0;
   std::copy( controls.begin(), controls.end(), back_inserter( controls_new0 ) );
-  if ( dependencies.find( var_index ) == dependencies.end() && !is_const )
+  if ( !is_const && dependencies.find( var_index ) == dependencies.end() )
   {
     auto ctrl0 = var_index * 2 + 1; /* negetive control: /2 ---> index %2 ---> sign */
     controls_new0.emplace_back( ctrl0 );
   }
   std::vector<uint32_t> controls_new1;
   std::copy( controls.begin(), controls.end(), back_inserter( controls_new1 ) );
-  if ( dependencies.find( var_index ) == dependencies.end() && !is_const )
+  if ( !is_const && dependencies.find( var_index ) == dependencies.end() )
   {
     auto ctrl1 = var_index * 2 + 0; /* positive control: /2 ---> index %2 ---> sign */
     controls_new1.emplace_back( ctrl1 );
@@ -539,6 +601,8 @@ struct state_preparation_parameters
 {
   bool verbose{false};
   bool use_upperbound{true};
+  /* reuse dependencies across reorderings of the same function */
+  bool use_dependency_cache{true};
 }; 
 
 struct state_preparation_statistics
@@ -547,6 +611,12 @@ struct state_preparation_statistics
   uint64_t num_unique_functions{0};
   uint64_t num_cnots{0};
   uint64_t num_sqgs{0};
+  /* targets whose dependency was (not) found in the dependency cache */
+  uint64_t num_dependency_cache_hits{0};
+  uint64_t num_dependency_cache_misses{0};
+  /* targets passed to the dependency analysis, and targets skipped because no dependency can exist */
+  uint64_t num_analysed_targets{0};
+  uint64_t num_skipped_targets{0};
   stopwatch<>::duration_type time_cache{0};
   stopwatch<>::duration_type time_total{0};
 
@@ -577,6 +647,7 @@ class qsp_deps
 public:
   using dependency_params = typename DependencyAnalysisStrategy::parameter_type;
   using dependency_stats = typename DependencyAnalysisStrategy::statistics_type;
+  using dependencies_type = decltype( std::declval<typename DependencyAnalysisStrategy::result_type>().dependencies );
 
 public:
   explicit qsp_deps(Network& ntk, DependencyAnalysisStrategy& dependency_strategy, ReorderingStrategy& order_strategy,
@@ -619,8 +690,9 @@ public:
     std::pair<uint32_t, uint32_t> max = {std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint64_t>::max()};
     std::pair<uint32_t, uint32_t> const ub = ps.use_upperbound ? upperbound : max;
     network best_ntk{{},ub};
-    order_strategy.foreach_reordering( tt, [this,&best_ntk]( kitty::dynamic_truth_table const& tt ){
-        network ntk = synthesize_network( tt );
+    dependency_cache.clear();
+    order_strategy.foreach_reordering( tt, [this,&best_ntk]( kitty::dynamic_truth_table const& tt, std::vector<uint32_t> const& order ){
+        network ntk = synthesize_network( tt, order );
         //print_gates(ntk.gates);
         
         if ( ntk.cnots_sqgs.first < best_ntk.cnots_sqgs.first )
@@ -647,6 +719,19 @@ public:
   }
 
   network synthesize_network( kitty::dynamic_truth_table const& tt )
+  {
+    std::vector<uint32_t> order( tt.num_vars() );
+    std::iota( std::begin( order ), std::end( order ), 0u );
+    dependency_cache.clear();
+    return synthesize_network( tt, order );
+  }
+
+  /*! \brief Synthesizes a reordering of the current function
+
+    `order[i]` is the variable of the original function at position `i`
+    of `tt`.
+  */
+  network synthesize_network( kitty::dynamic_truth_table const& tt, std::vector<uint32_t> const& order )
   {
     /* FIXME: treat const0 as a special case */
     if ( kitty::is_const0( tt ) )
@@ -654,44 +739,115 @@ public:
       return network{{}, std::make_pair(0u, 0u)};
     }
 
-    /* extract dependencies */
-    auto const result = dependency_strategy.run( tt );
-    //result.print();
+    /* the columns are prepared once and shared by the analyses of all targets and the constant-line check */
+    function_columns const prepared( compute_column_matrix( tt ) );
+
+    /* dependencies are only computed for the targets that gate generation asks for */
+    std::vector<uint32_t> positions( tt.num_vars() );
+    for ( auto i = 0u; i < positions.size(); ++i )
+    {
+      positions[order[i]] = i;
+    }
+    lazy_dependencies<dependencies_type> dependencies( tt.num_vars(), [&]( uint32_t target ) {
+      return lookup_dependency( tt, prepared, order, positions, target );
+    } );
 
     /* construct gates */
-    return create_gates( tt, result.dependencies );
+    return create_gates( tt, prepared.zero_lines, prepared.one_lines, dependencies );
   }
 
-  template<typename Dependencies>
-  network create_gates( kitty::dynamic_truth_table const& tt, Dependencies const& dependencies )
+  /*! \brief Returns the dependency of the target at position `target`, reusing the results of earlier reorderings
+
+    Permuting the variables does not change the columns, only which of
+    them precede a target.  The dependency of the target at position `i`
+    only depends on the set of variables at positions `i+1, ...`, so it
+    is cached under (target, set of later variables) in the variable
+    names of the original function.  The analysis is bounded by the upper
+    bound of the target (see `compute_upperbound_cost`), which is what
+    gate generation pays without a dependency, such that it only looks
+    for dependencies that lower the cost.  It is skipped if all later
+    variables are constant, i.e., if the upper bound is a single CNOT that
+    no dependency can save.
+  */
+  std::optional<typename dependencies_type::mapped_type> lookup_dependency( kitty::dynamic_truth_table const& tt, function_columns const& prepared,
+                                                                            std::vector<uint32_t> const& order, std::vector<uint32_t> const& positions, uint32_t target )
   {
-    
     uint32_t const num_variables = tt.num_vars();
-    uint32_t const var_index = num_variables - 1;
+    assert( num_variables <= 64u );
 
-    std::vector<uint32_t> zero_lines, one_lines;
-    extract_independent_vars( zero_lines, one_lines, tt );
+    uint64_t later_vars = 0u;
+    for ( auto i = target + 1u; i < num_variables; ++i )
+    {
+      later_vars |= uint64_t( 1 ) << order[i];
+    }
 
-    gates_t gates;
-    std::vector<uint32_t> cs;
-    if ( !dependencies.empty() )
+    if ( ps.use_dependency_cache )
+    {
+      auto const it = dependency_cache.find( {order[target], later_vars} );
+      if ( it != std::end( dependency_cache ) )
+      {
+        ++st.num_dependency_cache_hits;
+        if ( it->second )
+        {
+          return rename_dependency( *it->second, positions );
+        }
+        return std::nullopt;
+      }
+      ++st.num_dependency_cache_misses;
+    }
+
+    auto const is_later_const = [&]( uint32_t i ) { return i > target; };
+    uint32_t const num_const_later = std::count_if( std::begin( prepared.zero_lines ), std::end( prepared.zero_lines ), is_later_const ) +
+                                     std::count_if( std::begin( prepared.one_lines ), std::end( prepared.one_lines ), is_later_const );
+
+    std::optional<typename dependencies_type::mapped_type> dependency;
+    if ( num_variables - target - 1u > num_const_later )
     {
-      MC_qg_generation( gates, num_variables, tt, var_index, cs, dependencies, zero_lines, one_lines );      
+      ++st.num_analysed_targets;
+      auto const result = dependency_strategy.run( tt, prepared, std::vector<uint32_t>{target}, true );
+      auto const it = result.dependencies.find( target );
+      if ( it != std::end( result.dependencies ) )
+      {
+        dependency = it->second;
+      }
     }
     else
     {
-      MC_qg_generation( gates, tt, var_index, cs, zero_lines, one_lines );
+      ++st.num_skipped_targets;
     }
 
+    if ( ps.use_dependency_cache )
+    {
+      auto& entry = dependency_cache[{order[target], later_vars}];
+      if ( dependency )
+      {
+        entry = rename_dependency( *dependency, order );
+      }
+      else
+      {
+        entry = std::nullopt;
+      }
+    }
+    return dependency;
+  }
+
+  template<typename Dependencies>
+  network create_gates( kitty::dynamic_truth_table const& tt, std::vector<uint32_t> const& zero_lines, std::vector<uint32_t> const& one_lines,
+                        lazy_dependencies<Dependencies>& dependencies )
+  {
+    uint32_t const num_variables = tt.num_vars();
+    uint32_t const var_index = num_variables - 1;
+
+    gates_t gates;
+    std::vector<uint32_t> cs;
+    MC_qg_generation( gates, num_variables, tt, var_index, cs, dependencies, zero_lines, one_lines );
+
     /* FIXME: compute CNOT costs */
     qsp_1bench_stats st;
     std::map<uint32_t, bool> have_deps;
-    for ( auto i = 0u; i < num_variables; i++ )
+    for ( auto const& [i, _] : dependencies.computed_dependencies() )
     {
-      if ( dependencies.find( i ) != dependencies.end() )
-      {
-        have_deps[i] = true;
-      }
+      have_deps[i] = true;
     }
     gates_statistics( gates, have_deps, num_variables, st );
 
@@ -706,6 +862,9 @@ protected:
   state_preparation_statistics& st;
 
   std::unordered_map<kitty::dynamic_truth_table, network, kitty::hash<kitty::dynamic_truth_table>> cache;
+
+  /* dependencies of the current function by (target, set of later variables), in the variable names of the function */
+  std::map<std::pair<uint32_t, uint64_t>, std::optional<typename dependencies_type::mapped_type>> dependency_cache;
 }; 
 
 } // namespace angel
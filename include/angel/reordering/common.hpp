@@ -0,0 +1,34 @@
+#pragma once
+
+#include <type_traits>
+#include <vector>
+
+#include <kitty/kitty.hpp>
+
+namespace angel
+{
+
+namespace detail
+{
+
+/*! \brief Calls the callback of `foreach_reordering` with a reordered function and its order
+
+  Callbacks that only take the function, `fn( tt )`, are supported as
+  well, the order is not passed to them.
+*/
+template<typename Fn>
+decltype( auto ) call_reordering_callback( Fn&& fn, kitty::dynamic_truth_table const& tt, std::vector<uint32_t> const& order )
+{
+  if constexpr ( std::is_invocable_v<Fn, kitty::dynamic_truth_table const&, std::vector<uint32_t> const&> )
+  {
+    return fn( tt, order );
+  }
+  else
+  {
+    return fn( tt );
+  }
+}
+
+} /* namespace detail */
+
+} /* namespace angel */
@@ -1,6 +1,10 @@
 #include <algorithm>
+#include <numeric>
 #include <vector>
 
+#include "../utils/helper_functions.hpp"
+#include "common.hpp"
+
 #include <kitty/kitty.hpp>
 
 namespace angel
@@ -23,8 +27,10 @@ public:
     do
     {
       kitty::dynamic_truth_table tt_( tt );
-      angel::reordering_on_tt_inplace( tt_, perm );
-      fn( tt_ );
+      std::vector<uint32_t> order( tt.num_vars() );
+      std::iota( std::begin( order ), std::end( order ), 0u );
+      angel::reordering_on_tt_inplace( tt_, perm, &order );
+      detail::call_reordering_callback( fn, tt_, order );
     }
     while ( std::next_permutation( std::begin( perm ), std::end( perm ) ) );
   }
@@ -1,9 +1,12 @@
 #include <algorithm>
 #include <chrono>
+#include <numeric>
 #include <random>
 #include <vector>
 #include <kitty/kitty.hpp>
 
+#include "common.hpp"
+
 namespace angel
 {
 
@@ -17,13 +20,17 @@ public:
 
     uint32_t const num_variables = tt.num_vars();
 
-    fn( first_tt );
+    /* maps each position of the current tt to a variable of the original tt */
+    std::vector<uint32_t> order( num_variables );
+    std::iota( order.begin(), order.end(), 0u );
+
+    detail::call_reordering_callback( fn, first_tt, order );
 
     std::vector<uint8_t> perm( num_variables );
     std::iota( perm.begin(), perm.end(), 0u );
     std::reverse( perm.begin(), perm.end() );
 
-    uint32_t best_cost = initial_cost ? *initial_cost : fn( tt );
+    uint32_t best_cost = initial_cost ? *initial_cost : detail::call_reordering_callback( fn, tt, order );
     bool forward = true;
     bool improvement = true;
 
@@ -39,11 +46,15 @@ public:
         if ( next_tt == first_tt || next_tt == tt )
           continue;
 
-        uint32_t const cost = fn( next_tt );
+        std::vector<uint32_t> next_order( order );
+        std::swap( next_order[perm[i]], next_order[perm[i + 1]] );
+
+        uint32_t const cost = detail::call_reordering_callback( fn, next_tt, next_order );
         if ( cost < best_cost )
         {
           best_cost = cost;
           tt = next_tt;
+          order = next_order;
           std::swap( perm[i], perm[i + 1] );
           local_improvement = true;
         }
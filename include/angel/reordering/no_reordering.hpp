@@ -1,6 +1,9 @@
 #include <algorithm>
+#include <numeric>
 #include <vector>
 
+#include "common.hpp"
+
 #include <kitty/kitty.hpp>
 
 namespace angel
@@ -13,7 +16,10 @@ public:
   void foreach_reordering( kitty::dynamic_truth_table const& tt, Fn&& fn, std::optional<uint32_t> initial_cost = std::nullopt ) const
   {
     (void)initial_cost;
-    fn( tt );
+
+    std::vector<uint32_t> order( tt.num_vars() );
+    std::iota( std::begin( order ), std::end( order ), 0u );
+    detail::call_reordering_callback( fn, tt, order );
   }
 }; 
 
@@ -1,8 +1,12 @@
 #include <algorithm>
 #include <chrono>
+#include <numeric>
 #include <random>
 #include <vector>
 
+#include "../utils/helper_functions.hpp"
+#include "common.hpp"
+
 namespace angel
 {
 
@@ -20,7 +24,12 @@ public:
   {
     (void)initial_cost;
 
-    fn( tt );
+    std::vector<uint32_t> const identity = [&]() {
+      std::vector<uint32_t> order( tt.num_vars() );
+      std::iota( std::begin( order ), std::end( order ), 0u );
+      return order;
+    }();
+    detail::call_reordering_callback( fn, tt, identity );
 
     if ( num_reordering == 0u )
       return;
@@ -40,11 +49,12 @@ public:
       if ( std::find( std::begin( orders ), std::end( orders ), perm ) == orders.end() )
       {
         kitty::dynamic_truth_table tt_( tt );
-        angel::reordering_on_tt_inplace( tt_, perm );
+        std::vector<uint32_t> order( identity );
+        angel::reordering_on_tt_inplace( tt_, perm, &order );
 
         if ( tt != tt_ )
         {
-          fn( tt_ );
+          detail::call_reordering_callback( fn, tt_, order );
           orders.emplace_back( perm );
           std::sort( std::begin( perm ), std::end( perm ) );
         }
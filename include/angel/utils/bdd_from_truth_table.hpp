@@ -0,0 +1,117 @@
+/* angel: C++ state preparation library
+ * Copyright (C) 2019-2020  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*!
+  \file bdd_from_truth_table.hpp
+  \brief Construction of BDDs from truth tables
+*/
+
+#pragma once
+
+#include <cplusplus/cuddObj.hh>
+#include <kitty/dynamic_truth_table.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace angel
+{
+
+namespace detail
+{
+
+/*! \brief BDD of the bits `offset, ..., offset + 2^k - 1` of a truth table over its variables `0, ..., k-1`, variable `i` is `vars[i]`
+
+  The table is split on its highest variable, which is the lower half
+  (cofactor 0) and the upper half (cofactor 1) of the bits.  Constant
+  halves and equal halves are detected on whole words before any BDD
+  operation, and tables of at most 6 variables are handled within one
+  word.
+*/
+inline BDD create_bdd_from_truth_table_rec( Cudd const& cudd, kitty::dynamic_truth_table const& tt, std::vector<BDD> const& vars, uint64_t offset, uint32_t k )
+{
+  if ( k <= 6u )
+  {
+    uint64_t const mask = k == 6u ? ~uint64_t( 0 ) : ( ( uint64_t( 1 ) << ( 1u << k ) ) - 1u );
+    uint64_t const bits = ( tt._bits[offset >> 6u] >> ( offset & 63u ) ) & mask;
+    if ( bits == 0u )
+    {
+      return cudd.bddZero();
+    }
+    if ( bits == mask )
+    {
+      return cudd.bddOne();
+    }
+
+    uint32_t const half = 1u << ( k - 1u );
+    uint64_t const half_mask = ( uint64_t( 1 ) << half ) - 1u;
+    if ( ( bits & half_mask ) == ( bits >> half ) )
+    {
+      return create_bdd_from_truth_table_rec( cudd, tt, vars, offset, k - 1u );
+    }
+  }
+  else
+  {
+    uint64_t const first = offset >> 6u;
+    uint64_t const num_words = uint64_t( 1 ) << ( k - 6u );
+    auto const begin = tt.cbegin() + first;
+    auto const end = begin + num_words;
+    if ( std::all_of( begin, end, []( uint64_t w ) { return w == 0u; } ) )
+    {
+      return cudd.bddZero();
+    }
+    if ( std::all_of( begin, end, []( uint64_t w ) { return w == ~uint64_t( 0 ); } ) )
+    {
+      return cudd.bddOne();
+    }
+    if ( std::equal( begin, begin + num_words / 2u, begin + num_words / 2u ) )
+    {
+      return create_bdd_from_truth_table_rec( cudd, tt, vars, offset, k - 1u );
+    }
+  }
+
+  uint64_t const half_size = uint64_t( 1 ) << ( k - 1u );
+  auto const low = create_bdd_from_truth_table_rec( cudd, tt, vars, offset, k - 1u );
+  auto const high = create_bdd_from_truth_table_rec( cudd, tt, vars, offset + half_size, k - 1u );
+  return vars[k - 1u].Ite( high, low );
+}
+
+} /* namespace detail */
+
+/*! \brief Creates the BDD of a truth table, variable `i` of the truth table is `vars[i]`
+
+  The table is split on its variables from the last to the first, and
+  the BDD is built bottom-up with one `ite` per Shannon node.  This is
+  linear in the size of the table if `vars` is ordered from the bottom
+  to the top of the variable order.
+*/
+inline BDD create_bdd_from_truth_table( Cudd const& cudd, kitty::dynamic_truth_table const& tt, std::vector<BDD> const& vars )
+{
+  return detail::create_bdd_from_truth_table_rec( cudd, tt, vars, 0u, tt.num_vars() );
+}
+
+} /* namespace angel */
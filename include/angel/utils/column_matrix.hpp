@@ -0,0 +1,149 @@
+/* angel: C++ state preparation library
+ * Copyright (C) 2019-2020  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file column_matrix.hpp
+  \brief Column vectors of the on-set of a Boolean function
+*/
+
+#pragma once
+
+#include <kitty/kitty.hpp>
+#include <kitty/partial_truth_table.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace angel
+{
+
+namespace detail
+{
+
+/*! \brief Transposes a 64x64 bit-matrix in place
+
+  Bit `c` of word `r` is swapped with bit `r` of word `c`.  The six
+  delta-swap rounds are branch-free and operate on independent words,
+  such that compilers can vectorize them.
+*/
+inline void transpose64( std::array<uint64_t, 64u>& a )
+{
+  uint64_t mask = UINT64_C( 0x00000000ffffffff );
+  for ( uint32_t j = 32u; j != 0u; j >>= 1u, mask ^= mask << j )
+  {
+    for ( uint32_t k = 0u; k < 64u; k = ( ( k | j ) + 1u ) & ~j )
+    {
+      uint64_t const t = ( ( a[k] >> j ) ^ a[k | j] ) & mask;
+      a[k] ^= t << j;
+      a[k | j] ^= t;
+    }
+  }
+}
+
+} /* namespace detail */
+
+/*! \brief Computes the column vectors of the on-set of a function
+
+  The on-set minterms of `function`, in increasing order, form the rows
+  of a matrix with one column per variable.  Column `i` holds the value
+  of variable `i` in every minterm.  Blocks of 64 minterms are
+  transposed at once, such that every column word is written once.
+
+  \param function Boolean function with at most 64 variables
+  \return One partial truth table of |on-set| bits per variable
+*/
+inline std::vector<kitty::partial_truth_table> compute_column_matrix( kitty::dynamic_truth_table const& function )
+{
+  uint32_t const num_vars = function.num_vars();
+  uint32_t const num_minterms = kitty::count_ones( function );
+
+  std::vector<kitty::partial_truth_table> columns( num_vars, kitty::partial_truth_table( num_minterms ) );
+
+  std::array<uint64_t, 64u> block;
+  uint32_t row = 0u;
+  uint32_t block_index = 0u;
+  auto const flush = [&]() {
+    std::fill( std::begin( block ) + row, std::end( block ), 0u );
+    detail::transpose64( block );
+    for ( auto i = 0u; i < num_vars; ++i )
+    {
+      columns[i]._bits[block_index] = block[i];
+    }
+    row = 0u;
+    ++block_index;
+  };
+
+  for ( auto w = 0u; w < function.num_blocks(); ++w )
+  {
+    uint64_t word = function._bits[w];
+    while ( word != 0u )
+    {
+      block[row++] = ( uint64_t( w ) << 6u ) + __builtin_ctzll( word );
+      word &= word - 1u;
+      if ( row == 64u )
+      {
+        flush();
+      }
+    }
+  }
+  if ( row != 0u )
+  {
+    flush();
+  }
+
+  return columns;
+}
+
+/*! \brief Computes the row signatures of a set of columns
+
+  Bit `j` of the signature of row `l` is bit `l` of column `j`, i.e., the
+  inverse of `compute_column_matrix` restricted to the given columns.
+
+  \param columns At most 64 columns with the same number of bits
+  \return One signature per row
+*/
+inline std::vector<uint64_t> compute_row_signatures( std::vector<kitty::partial_truth_table> const& columns )
+{
+  assert( columns.size() <= 64u );
+  uint32_t const num_rows = columns.empty() ? 0u : columns[0u].num_bits();
+
+  std::vector<uint64_t> signatures( num_rows );
+  std::array<uint64_t, 64u> block;
+  for ( auto b = 0u; 64u * b < num_rows; ++b )
+  {
+    for ( auto j = 0u; j < 64u; ++j )
+    {
+      block[j] = j < columns.size() ? columns[j]._bits[b] : 0u;
+    }
+    detail::transpose64( block );
+    std::copy( std::begin( block ), std::begin( block ) + std::min( 64u, num_rows - 64u * b ), std::begin( signatures ) + 64u * b );
+  }
+  return signatures;
+}
+
+} /* namespace angel */
@@ -2,6 +2,7 @@
 
 #include <kitty/dynamic_truth_table.hpp>
 #include <kitty/operations.hpp>
+#include <angel/utils/column_matrix.hpp>
 #include <angel/utils/partial_truth_table.hpp>
 
 namespace angel
@@ -15,56 +16,32 @@ inline std::vector<uint32_t> initialize_orders(uint32_t n)
     return orders_init;
 }
 
+/* collects the constant columns from the last to the first variable */
 inline void extract_independent_vars (std::vector<uint32_t> &zero_lines, std::vector<uint32_t> &one_lines, 
-kitty::dynamic_truth_table const& tt)
-{       
-    /* extract minterms */
-    //print_binary(tt);
-    //std::cout<<std::endl;
-
-    std::vector<partial_truth_table> minterms = on_set( tt );
-    // for(auto i=0u; i<minterms.size(); i++)
-    //     print_binary(minterms[i]);
-    // std::cout<<std::endl;
-    
-
-    /* convert minterms to column vectors */
-    uint32_t const minterm_length = minterms[0u].num_bits();
-    uint32_t const num_minterms = minterms.size();
-
-    std::vector<partial_truth_table> columns( minterm_length, partial_truth_table( num_minterms ) );
-    for ( auto i = 0u; i < minterm_length; ++i )
-    {
-        for ( auto j = 0u; j < num_minterms; ++j )
-        {
-            if ( minterms.at( j ).get_bit( i ) )
-            {
-                columns[i/*minterm_length-i-1*/].set_bit( j );
-            }
-        }
-    }
-
-    for(int32_t i=minterm_length-1; i>=0; i--)
+std::vector<kitty::partial_truth_table> const& columns)
+{
+    for(int32_t i=columns.size()-1; i>=0; i--)
     {
-        if(columns.at(i).is_const0())
+        if(kitty::is_const0(columns.at(i)))
         {
             zero_lines.emplace_back(i);
         }
             
-        else if(columns.at(i).is_const1())
+        else if(kitty::is_const0(~columns.at(i)))
         {
             one_lines.emplace_back(i);
         }
     }
+}
 
-    // for(auto i=0u; i<columns.size(); i++)
-    // {
-    //     print_binary(columns[i]);
-    //     std::cout<<std::endl;
-    // }
+inline void extract_independent_vars (std::vector<uint32_t> &zero_lines, std::vector<uint32_t> &one_lines, 
+kitty::dynamic_truth_table const& tt)
+{       
+    extract_independent_vars( zero_lines, one_lines, compute_column_matrix( tt ) );
 }
 
-inline std::vector<uint32_t> reordering_on_tt_inplace (kitty::dynamic_truth_table &tt, std::vector<uint32_t> orders)
+/* if `names` is given, the same swaps are applied to it, such that it maps each position of the reordered tt to a variable of the original tt */
+inline std::vector<uint32_t> reordering_on_tt_inplace (kitty::dynamic_truth_table &tt, std::vector<uint32_t> orders, std::vector<uint32_t>* names = nullptr)
 {
     auto var_num = orders.size();
     std::vector<uint32_t> new_order;
@@ -79,6 +56,8 @@ inline std::vector<uint32_t> reordering_on_tt_inplace (kitty::dynamic_truth_tabl
                 if(j == orders[i])
                 {
                     kitty::swap_inplace(tt, i, j); 
+                    if (names)
+                        std::swap((*names)[i], (*names)[j]);
                     new_order.emplace_back(j);
                     break;
                 }
@@ -0,0 +1,110 @@
+/* angel: C++ state preparation library
+ * Copyright (C) 2019-2020  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file lru_cache.hpp
+  \brief Bounded map that evicts the least recently used entry
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <utility>
+
+namespace angel
+{
+
+/*! \brief Map with at most `capacity` entries
+
+  `find` and `insert` mark an entry as most recently used, and inserting
+  into a full cache evicts the least recently used entry.
+*/
+template<typename Key, typename Value>
+class lru_cache
+{
+public:
+  explicit lru_cache( uint64_t capacity )
+    : capacity( capacity )
+  {
+  }
+
+  /*! \brief Returns the value of `key`, or `nullptr` if it is not in the cache */
+  Value const* find( Key const& key )
+  {
+    auto const it = positions.find( key );
+    if ( it == positions.end() )
+    {
+      return nullptr;
+    }
+
+    entries.splice( entries.begin(), entries, it->second );
+    return &it->second->second;
+  }
+
+  void insert( Key const& key, Value value )
+  {
+    if ( capacity == 0u )
+    {
+      return;
+    }
+
+    if ( auto const it = positions.find( key ); it != positions.end() )
+    {
+      it->second->second = std::move( value );
+      entries.splice( entries.begin(), entries, it->second );
+      return;
+    }
+
+    if ( entries.size() >= capacity )
+    {
+      positions.erase( entries.back().first );
+      entries.pop_back();
+    }
+    entries.emplace_front( key, std::move( value ) );
+    positions.emplace( key, entries.begin() );
+  }
+
+  uint64_t size() const
+  {
+    return entries.size();
+  }
+
+  void clear()
+  {
+    positions.clear();
+    entries.clear();
+  }
+
+private:
+  uint64_t capacity;
+
+  /* entries from the most to the least recently used */
+  std::list<std::pair<Key, Value>> entries;
+  std::map<Key, typename std::list<std::pair<Key, Value>>::iterator> positions;
+};
+
+} /* namespace angel */
@@ -115,10 +115,20 @@ public:
 		}
 	}
 
+	/*! \brief Interrupts the current and all later calls to `solve`
+	 *
+	 * May be called from another thread; interrupted calls return
+	 * `undefined`.
+	 */
+	void interrupt()
+	{
+		solver_->interrupt();
+	}
+
 	result::states solve(std::vector<lit_type> const& assumptions = {},
 	                     uint32_t conflict_limit = 0)
 	{
-		if (state_ != result::states::dirty) {
+		if (state_ != result::states::dirty && assumptions.empty()) {
 			return state_;
 		}
 
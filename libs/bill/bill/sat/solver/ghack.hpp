@@ -2120,6 +2120,8 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #ifndef Ghack_Solver_h
 #define Ghack_Solver_h
 
+#include <atomic>
+
 
 
 
@@ -2358,7 +2360,7 @@ protected:
     //
     int64_t             conflict_budget;    // -1 means no budget.
     int64_t             propagation_budget; // -1 means no budget.
-    bool                asynch_interrupt;
+    std::atomic<bool>   asynch_interrupt;
 
 
     // Variables added for incremental mode
@@ -2509,11 +2511,11 @@ inline void     Solver::setDecisionVar(Var v, bool b)
 }
 inline void     Solver::setConfBudget(int64_t x){ conflict_budget    = conflicts    + x; }
 inline void     Solver::setPropBudget(int64_t x){ propagation_budget = propagations + x; }
-inline void     Solver::interrupt(){ asynch_interrupt = true; }
-inline void     Solver::clearInterrupt(){ asynch_interrupt = false; }
+inline void     Solver::interrupt(){ asynch_interrupt.store(true, std::memory_order_relaxed); }
+inline void     Solver::clearInterrupt(){ asynch_interrupt.store(false, std::memory_order_relaxed); }
 inline void     Solver::budgetOff(){ conflict_budget = propagation_budget = -1; }
 inline bool     Solver::withinBudget() const {
-    return !asynch_interrupt &&
+    return !asynch_interrupt.load(std::memory_order_relaxed) &&
            (conflict_budget    < 0 || conflicts < (uint64_t)conflict_budget) &&
            (propagation_budget < 0 || propagations < (uint64_t)propagation_budget); }
 
@@ -3915,10 +3917,10 @@ printf("c ==================================[ Search Statistics (every %6d confl
      w = !H ? 10000 : a + G * a;
 
      var_decay = G ? .95 : .999;
-     while (status == l_Undef && w > 0)
+     while (status == l_Undef && w > 0 && withinBudget())
       status = search(w); // the parameter is useless in glucose, kept to allow modifications
 
-        //if (!withinBudget()) break;
+        if (!withinBudget()) break;
         curr_restarts++;
 
         if (!(G = !G)) a += a / 10;
@@ -4679,7 +4681,7 @@ inline bool SimpSolver::backwardSubsumptionCheck(bool verbose)
     while (subsumption_queue.size() > 0 || bwdsub_assigns < trail.size()){
 
         // Empty subsumption queue and return immediately on user-interrupt:
-        if (asynch_interrupt){
+        if (asynch_interrupt.load(std::memory_order_relaxed)){
             subsumption_queue.clear();
             bwdsub_assigns = trail.size();
             break; }
@@ -4951,7 +4953,7 @@ inline bool SimpSolver::eliminate(bool turn_off_elim)
             ok = false; goto cleanup; }
 
         // Empty elim_heap and return immediately on user-interrupt:
-        if (asynch_interrupt){
+        if (asynch_interrupt.load(std::memory_order_relaxed)){
             assert(bwdsub_assigns == trail.size());
             assert(subsumption_queue.size() == 0);
             assert(n_touched == 0);
@@ -4962,7 +4964,7 @@ inline bool SimpSolver::eliminate(bool turn_off_elim)
         for (int cnt = 0; !elim_heap.empty(); cnt++){
             Var elim = elim_heap.removeMin();
             
-            if (asynch_interrupt) break;
+            if (asynch_interrupt.load(std::memory_order_relaxed)) break;
 
             if (isEliminated(elim) || value(elim) != l_Undef) continue;
 
@@ -39,6 +39,17 @@
 #include <bill/sat/solver.hpp>
 #include <bill/sat/tseytin.hpp>
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace easy
 {
@@ -49,10 +60,49 @@ struct compute_esop_cover_from_divisors_parameters
   uint32_t max_num_cubes{0u};
 
   uint32_t num_conflicts{1000u};
+
+  /* use one SAT solver for all cube counts: cubes are enabled by
+     activation literals, the bound is set with assumptions, and learned
+     clauses are kept between bounds */
+  bool incremental{true};
+
+  /* order interchangeable cubes lexicographically */
+  bool break_symmetries{true};
+
+  /* search the number of cubes by galloping and bisection instead of
+     decreasing it by one */
+  bool bisection{true};
+
+  /* SAT solver backends: with more than one backend, each backend
+     solves the problem in its own thread and the first answer is taken;
+     only glucose_41 and ghack can be interrupted and are supported, the
+     list must not be empty */
+  std::vector<bill::solvers> solvers{bill::solvers::glucose_41};
+
+  /* maximum number of portfolio threads: 0 means one thread per backend */
+  uint32_t num_threads{0u};
+
+  /* only covers with a smaller CNOT cost are returned, e.g., the cost of
+     a known cover; since all cubes but one cost at least one CNOT, the
+     bound also limits the number of cubes */
+  uint32_t max_cost{std::numeric_limits<uint32_t>::max()};
+
+  /* wall-clock limit in milliseconds: 0 means no limit; no SAT call is
+     started after the limit and the best cover found so far is returned */
+  uint32_t time_limit{0u};
 };
 
 struct compute_esop_cover_from_divisors_statistics
 {
+  /* number of SAT solver calls */
+  uint32_t num_sat_calls{0u};
+
+  /* number of rows of the covering problems and number of distinct rows encoded */
+  uint32_t num_rows{0u};
+  uint32_t num_encoded_rows{0u};
+
+  /* true if the time limit ran out */
+  bool timed_out{false};
 };
 
 struct compute_esop_cover_from_divisors_result_type
@@ -62,13 +112,111 @@ struct compute_esop_cover_from_divisors_result_type
   std::optional<std::vector<easy::cube>> esop_cover;
 };
 
+namespace detail
+{
+
+/*! \brief Shared state of the threads of a SAT solver portfolio
+
+  Each thread registers the SAT solver it currently uses.  The first
+  thread that finishes interrupts the solvers of all other threads.
+*/
+class solver_portfolio
+{
+public:
+  /* registers a solver of a thread during its lifetime */
+  class registration
+  {
+  public:
+    template<typename Solver>
+    explicit registration( solver_portfolio* portfolio, uint32_t index, Solver& solver )
+      : portfolio( portfolio )
+      , index( index )
+    {
+      if ( portfolio )
+      {
+        portfolio->attach( index, [&solver]() { solver.interrupt(); } );
+      }
+    }
+
+    ~registration()
+    {
+      if ( portfolio )
+      {
+        portfolio->attach( index, nullptr );
+      }
+    }
+
+    registration( registration const& ) = delete;
+    registration& operator=( registration const& ) = delete;
+
+  private:
+    solver_portfolio* portfolio;
+    uint32_t index;
+  };
+
+  explicit solver_portfolio( uint32_t num_threads )
+    : interrupts( num_threads )
+  {
+  }
+
+  /* returns true for the first thread that finishes and interrupts the solvers of all other threads */
+  bool finish( uint32_t index )
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    if ( done )
+    {
+      return false;
+    }
+
+    done = true;
+    for ( auto i = 0u; i < interrupts.size(); ++i )
+    {
+      if ( i != index && interrupts[i] )
+      {
+        interrupts[i]();
+      }
+    }
+    return true;
+  }
+
+private:
+  void attach( uint32_t index, std::function<void()> interrupt )
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    if ( done && interrupt )
+    {
+      /* solvers created after the portfolio is done return immediately */
+      interrupt();
+    }
+    interrupts[index] = interrupt;
+  }
+
+  std::mutex mutex;
+  bool done{false};
+  std::vector<std::function<void()>> interrupts;
+};
+
+} // namespace detail
+
 class compute_esop_cover_from_divisors_impl
 {
 public:
   explicit compute_esop_cover_from_divisors_impl( compute_esop_cover_from_divisors_parameters const& ps, compute_esop_cover_from_divisors_statistics& st )
     : ps( ps )
     , st( st )
+    , deadline( ps.time_limit == 0u ? std::chrono::steady_clock::time_point::max() : std::chrono::steady_clock::now() + std::chrono::milliseconds( ps.time_limit ) )
   {
+    if ( ps.solvers.empty() )
+    {
+      throw std::invalid_argument( "compute_esop_cover_from_divisors: no SAT solver backend given" );
+    }
+    for ( auto const backend : ps.solvers )
+    {
+      if ( backend != bill::solvers::glucose_41 && backend != bill::solvers::ghack )
+      {
+        throw std::invalid_argument( "compute_esop_cover_from_divisors: only the glucose_41 and ghack backends are supported" );
+      }
+    }
   }
 
   compute_esop_cover_from_divisors_result_type run( kitty::partial_truth_table const& target, std::vector<kitty::partial_truth_table> const& divisor_functions )
@@ -155,205 +303,528 @@ public:
     /* n ... number of variables */
     /* k ... number of cubes/product terms */
     uint32_t const n = divisor_functions.size();
-    uint32_t const num_bits = target.num_bits();
+    uint32_t max_k = ps.max_num_cubes != 0 ? ps.max_num_cubes : divisor_functions.size();
+    if ( ps.max_cost != std::numeric_limits<uint32_t>::max() )
+    {
+      max_k = std::min( max_k, ps.max_cost );
+    }
+    if ( max_k == 0u )
+    {
+      return result;
+    }
+
+    /* encode each distinct row once */
+    std::vector<row_type> rows;
+    if ( !compute_unique_rows( target, divisor_functions, rows ) )
+    {
+      return result;
+    }
+    st.num_rows += target.num_bits();
+    st.num_encoded_rows += rows.size();
 
-    uint32_t best_cost = std::numeric_limits<uint32_t>::max();
-    for ( auto k = ps.max_num_cubes != 0 ? ps.max_num_cubes : divisor_functions.size(); k > 0u; --k )
+    std::vector<bill::solvers> backends( ps.solvers );
+    if ( ps.num_threads != 0u && backends.size() > ps.num_threads )
     {
+      backends.resize( ps.num_threads );
+    }
+
+    if ( backends.size() <= 1u )
+    {
+      solve( backends.front(), n, max_k, rows, result );
+      return result;
+    }
+    return solve_portfolio( backends, n, max_k, rows );
+  }
+
+private:
+  /* divisor values of a row (bit j is the value of divisor j) and the target value */
+  using row_type = std::pair<uint64_t, bool>;
+
+  /*! \brief Collapses the rows with the same divisor values and target value
+
+    Identical rows yield identical clauses, so each of them is encoded
+    once.  Returns false if two rows with the same divisor values have
+    different target values, in which case no cover exists.
+  */
+  bool compute_unique_rows( kitty::partial_truth_table const& target, std::vector<kitty::partial_truth_table> const& divisor_functions, std::vector<row_type>& rows ) const
+  {
+    assert( divisor_functions.size() <= 64u );
+
+    rows.clear();
+    rows.reserve( target.num_bits() );
+    for ( auto l = 0u; l < uint32_t( target.num_bits() ); ++l )
+    {
+      uint64_t signature = 0u;
+      for ( auto j = 0u; j < divisor_functions.size(); ++j )
+      {
+        signature |= uint64_t( kitty::get_bit( divisor_functions[j], l ) ) << j;
+      }
+      rows.emplace_back( signature, kitty::get_bit( target, l ) );
+    }
+
+    std::sort( std::begin( rows ), std::end( rows ) );
+    rows.erase( std::unique( std::begin( rows ), std::end( rows ) ), std::end( rows ) );
+
+    /* after sorting, rows with the same signature are adjacent */
+    for ( auto l = 1u; l < rows.size(); ++l )
+    {
+      if ( rows[l - 1u].first == rows[l].first )
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /* solves the covering problem with one SAT solver backend */
+  void solve( bill::solvers backend, uint32_t n, uint32_t max_k, std::vector<row_type> const& rows, compute_esop_cover_from_divisors_result_type& result,
+              detail::solver_portfolio* portfolio = nullptr, uint32_t index = 0u )
+  {
+    if ( backend == bill::solvers::ghack )
+    {
+      solve_with<bill::solvers::ghack>( n, max_k, rows, result, portfolio, index );
+    }
+    else
+    {
+      solve_with<bill::solvers::glucose_41>( n, max_k, rows, result, portfolio, index );
+    }
+  }
+
+  template<bill::solvers Solver>
+  void solve_with( uint32_t n, uint32_t max_k, std::vector<row_type> const& rows, compute_esop_cover_from_divisors_result_type& result,
+                   detail::solver_portfolio* portfolio, uint32_t index )
+  {
+    uint32_t best_cost = ps.max_cost;
+    if ( ps.incremental )
+    {
+      /* encode max_k cubes once and disable the cubes k, ..., max_k-1 with assumptions */
+      bill::solver<Solver> solver;
+      detail::solver_portfolio::registration const registration( portfolio, index, solver );
+      cover_encoding const enc( n, max_k, rows.size(), true );
+      add_constraints( solver, enc, rows );
+
+      /* the first cube is active for all bounds; adding this clause fails if the constraints are already unsatisfiable */
+      if ( !solver.add_clause( enc.a( 0u ) ) )
+      {
+        return;
+      }
+
+      search_num_cubes( max_k, [&]( uint32_t k, uint32_t& num_cubes ) {
+        // fmt::print( "[i] {}-term bounded ESOP synthesis for {}\n", k, kitty::to_binary( target ) );
+
+        std::vector<bill::lit_type> assumptions;
+        for ( auto i = 0u; i < max_k; ++i )
+        {
+          assumptions.push_back( i < k ? enc.a( i ) : ~enc.a( i ) );
+        }
+        return solve_and_minimize( solver, enc, k, assumptions, result, best_cost, num_cubes );
+      } );
+      return;
+    }
+
+    search_num_cubes( max_k, [&]( uint32_t k, uint32_t& num_cubes ) {
       // fmt::print( "[i] {}-term bounded ESOP synthesis for {}\n", k, kitty::to_binary( target ) );
 
       /* create a SAT solver */
-      bill::solver<bill::solvers::glucose_41> solver;
-
-      /* register 2*n*k p(i,j) and q(i,j) variables and additional k*num_bits auxiliary variables z(l,j) */
-      solver.add_variables( 2*n*k + k*num_bits );
-
-      /*  p- and q-variable layout:
-       *  (i,j) ----------------------------------------------------------------------------------------------------------------------------------------------> j < n
-       *    |     p(0,0)   = 0          q(0,0)   = 1               ...    p(0,n-1)   = 2*(n-1)               q(0,n-1)   = 2*(n-1) + 1
-       *    |     p(1,0)   = 2*n        q(1,0)   = 2*n + 1         ...    p(1,n-1)   = 2*n + 2*(n-1)         q(1,n-1)   = 2*n + 2*(n-1) + 1
-       *    |     .                     .                                 .                                  .
-       *    |     .                     .                                 .                                  .
-       *    |     .                     .                                 .                                  .
-       *    |     p(k-1,0) = 2*n*(k-1)  q(k-1,0) = 2*n*(k-1) + 1   ...    p(k-1,n-1) = 2*n*(k-1) + 2*(n-1)   q(k-1,n-1) = 2*n*(k-1) + 2*(n-1) + 1
-       *    v
-       *  i < k
-       *
-       *  2*n*k elements: q(0,0) == 0, ..., q(k-1,n-1) == 2*n*k - 1
-       */
-
-       /* z-variable layout:
-        * (l,j) ---------------------------------------------------------------------------------------------------------------------------------------------> j < k
-        *   |   z(0,0)          = 2*n*k                z(0,1)          = 2*n*k + 1                         ...   z(0,k-1)          = 2*n*k + k-1 
-        *   |   z(1,0)          = (2*n+1)*k            z(1,1)          = (2*n+1)*k + 1                     ...   z(1,k-1)          = (2*n+1)*k + k-1 
-        *   |   .                 .                    .                                                         .
-        *   |   .                 .                    .                                                         .
-        *   |   .                 .                    .                                                         .
-        *   |   z(num_bits-1,0) = (2*n+num_bits-1)*k   z(num_bits-1,1) = (2*n+num_bits-1)*k + 1            ...   z(num_bits-1,k-1) = (2*n+num_bits-1)*k + k-1 
-        *   v
-        * l < num_bits
-        *
-        * k*num_bits elements: z(0,0) == 2*n*k, ..., z(num_bits-1,k-1) == 2*n*k + k*num_bits - 1
-        */
-
-      auto const p = [&]( uint32_t i, uint32_t j ){
-        assert( i < k ); /* cube */
-        assert( j < n ); /* variable */
-        return bill::lit_type( bill::var_type( 2*n*i + 2*j ), bill::lit_type::polarities::positive );
-      };
-
-      auto const q = [&]( uint32_t i, uint32_t j ){
-        assert( i < k ); /* cube */
-        assert( j < n ); /* variable */
-        return bill::lit_type( bill::var_type( 2*n*i + 2*j + 1 ), bill::lit_type::polarities::positive );
-      };
-
-      auto const z = [&]( uint32_t l, uint32_t j ){
-        assert( l < num_bits ); /* minterm */
-        assert( j < k ); /* cube */
-        return bill::lit_type( bill::var_type( 2*n*k + k*l + j ), bill::lit_type::polarities::positive );
-      };
-
-      /* print layout */
-      // for ( auto i = 0u; i < k; ++i )
-      // {
-      //   for ( auto j = 0u; j < n; ++j )
-      //   {
-      //     fmt::print( "p({},{}) = {}\n", i, j, uint32_t( p( i, j ).variable() ) );
-      //   }
-      // }
-      //
-      // for ( auto i = 0u; i < k; ++i )
-      // {
-      //   for ( auto j = 0u; j < n; ++j )
-      //   {
-      //     fmt::print( "q({},{}) = {}\n", i, j, uint32_t( q( i, j ).variable() ) );
-      //   }
-      // }
-      //
-      // for ( auto l = 0u; l < num_bits; ++l )
-      // {
-      //   for ( auto j = 0u; j < k; ++j )
-      //   {
-      //     fmt::print( "z({},{}) = {}\n", l, j, uint32_t( z( l, j ).variable() ) );
-      //   }
-      // }
-
-      /* add constraints */
-      for ( auto l = 0u; l < num_bits; ++l ) /* for each row in the divisors */
-      {
-        /* positive */
-        for ( auto i = 0u; i < k; ++i ) /* for each ESOP cube */
+      bill::solver<Solver> solver;
+      detail::solver_portfolio::registration const registration( portfolio, index, solver );
+      cover_encoding const enc( n, k, rows.size(), false );
+      add_constraints( solver, enc, rows );
+
+      return solve_and_minimize( solver, enc, k, {}, result, best_cost, num_cubes );
+    } );
+  }
+
+  /*! \brief Solves the covering problem with several backends in parallel
+
+    Every thread runs the complete search with one backend.  The result
+    of the first thread that finishes is returned and the SAT solvers of
+    all other threads are interrupted.
+  */
+  compute_esop_cover_from_divisors_result_type solve_portfolio( std::vector<bill::solvers> const& backends, uint32_t n, uint32_t max_k, std::vector<row_type> const& rows )
+  {
+    uint32_t const num_threads = backends.size();
+
+    compute_esop_cover_from_divisors_result_type result;
+    std::vector<compute_esop_cover_from_divisors_statistics> thread_stats( num_threads );
+    detail::solver_portfolio portfolio( num_threads );
+
+    std::vector<std::thread> threads;
+    for ( auto t = 0u; t < num_threads; ++t )
+    {
+      threads.emplace_back( [&, t]() {
+        compute_esop_cover_from_divisors_result_type thread_result;
+        compute_esop_cover_from_divisors_impl( ps, thread_stats[t] ).solve( backends[t], n, max_k, rows, thread_result, &portfolio, t );
+        if ( portfolio.finish( t ) )
         {
-          for ( auto j = 0u; j < n; ++j ) /* for each variable */
-          {
-            std::vector<bill::lit_type> clause = { ~z( l, i ) };
-            clause.push_back( kitty::get_bit( divisor_functions[j], l ) ? ~q( i, j ) : ~p( i, j ) );
-            solver.add_clause( clause );
-          }
+          result = thread_result;
         }
+      } );
+    }
+    for ( auto& thread : threads )
+    {
+      thread.join();
+    }
 
-        /* negative */
-        for ( auto i = 0u; i < k; ++i ) /* for each ESOP cube */
+    for ( auto const& thread_st : thread_stats )
+    {
+      st.num_sat_calls += thread_st.num_sat_calls;
+      st.timed_out = st.timed_out || thread_st.timed_out;
+    }
+    return result;
+  }
+
+  /*! \brief Searches the smallest number of cubes
+
+    `solve( k, num_cubes )` returns true if a cover with at most `k` cubes
+    has been found and sets `num_cubes` to the size of the smallest cover
+    found.  Without bisection, `k` is decreased by one until `solve`
+    fails.  Otherwise, the bounds are first decreased in steps of 1, 2,
+    4, ... starting from the size of the found cover, and then bisected
+    between the largest failing and the smallest succeeding bound.
+  */
+  template<typename Fn>
+  void search_num_cubes( uint32_t max_k, Fn&& solve ) const
+  {
+    uint32_t num_cubes = max_k;
+    if ( !ps.bisection )
+    {
+      for ( auto k = max_k; k > 0u; --k )
+      {
+        if ( !solve( k, num_cubes ) )
         {
-          std::vector<bill::lit_type> clause = { z( l, i ) };
-          for ( auto j = 0u; j < n; ++j ) /* for each variable */
-          {
-            clause.push_back( kitty::get_bit( divisor_functions[j], l ) ? q( i, j ) : p( i, j ) );
-          }
-          solver.add_clause( clause );
+          return;
         }
+      }
+      return;
+    }
 
-        /* consider target function */
-        std::vector<bill::lit_type> clause;
-        for ( auto i = 0u; i < k; ++i ) /* for each ESOP cube */
+    if ( !solve( max_k, num_cubes ) )
+    {
+      return;
+    }
+
+    uint32_t lower = 0u; /* largest bound that failed */
+    uint32_t upper = std::min( max_k, num_cubes ); /* smallest bound that succeeded */
+    uint32_t step = 1u;
+    bool galloping = true;
+    while ( upper - lower > 1u )
+    {
+      uint32_t const k = galloping ? ( upper > lower + step ? upper - step : lower + 1u ) : lower + ( upper - lower ) / 2u;
+      num_cubes = k;
+      if ( solve( k, num_cubes ) )
+      {
+        upper = std::min( k, num_cubes );
+        step *= 2u;
+      }
+      else
+      {
+        lower = k;
+        galloping = false;
+      }
+    }
+  }
+
+  /*! \brief Variable layout of a k-term ESOP cover of a divisor covering problem
+
+      p- and q-variable layout:
+      (i,j) ----------------------------------------------------------------------------------------------------------------------------------------------> j < n
+        |     p(0,0)   = 0          q(0,0)   = 1               ...    p(0,n-1)   = 2*(n-1)               q(0,n-1)   = 2*(n-1) + 1
+        |     p(1,0)   = 2*n        q(1,0)   = 2*n + 1         ...    p(1,n-1)   = 2*n + 2*(n-1)         q(1,n-1)   = 2*n + 2*(n-1) + 1
+        |     .                     .                                 .                                  .
+        |     .                     .                                 .                                  .
+        |     .                     .                                 .                                  .
+        |     p(k-1,0) = 2*n*(k-1)  q(k-1,0) = 2*n*(k-1) + 1   ...    p(k-1,n-1) = 2*n*(k-1) + 2*(n-1)   q(k-1,n-1) = 2*n*(k-1) + 2*(n-1) + 1
+        v
+      i < k
+
+      2*n*k elements: q(0,0) == 0, ..., q(k-1,n-1) == 2*n*k - 1
+
+      z-variable layout:
+      (l,j) ---------------------------------------------------------------------------------------------------------------------------------------------> j < k
+        |   z(0,0)          = 2*n*k                z(0,1)          = 2*n*k + 1                         ...   z(0,k-1)          = 2*n*k + k-1
+        |   z(1,0)          = (2*n+1)*k            z(1,1)          = (2*n+1)*k + 1                     ...   z(1,k-1)          = (2*n+1)*k + k-1
+        |   .                 .                    .                                                         .
+        |   .                 .                    .                                                         .
+        |   .                 .                    .                                                         .
+        |   z(num_rows-1,0) = (2*n+num_rows-1)*k   z(num_rows-1,1) = (2*n+num_rows-1)*k + 1            ...   z(num_rows-1,k-1) = (2*n+num_rows-1)*k + k-1
+        v
+      l < num_rows
+
+      Each row stands for all minterms with the same divisor values, see `compute_unique_rows`.
+
+      k*num_rows elements: z(0,0) == 2*n*k, ..., z(num_rows-1,k-1) == 2*n*k + k*num_rows - 1
+
+      In incremental mode, k activation variables a(i) = 2*n*k + k*num_rows + i follow.
+  */
+  struct cover_encoding
+  {
+    explicit cover_encoding( uint32_t n, uint32_t k, uint32_t num_rows, bool with_activation )
+      : n( n ), k( k ), num_rows( num_rows ), with_activation( with_activation )
+    {
+    }
+
+    uint32_t num_variables() const
+    {
+      return 2*n*k + k*num_rows + ( with_activation ? k : 0u );
+    }
+
+    bill::lit_type p( uint32_t i, uint32_t j ) const
+    {
+      assert( i < k ); /* cube */
+      assert( j < n ); /* variable */
+      return bill::lit_type( bill::var_type( 2*n*i + 2*j ), bill::lit_type::polarities::positive );
+    }
+
+    bill::lit_type q( uint32_t i, uint32_t j ) const
+    {
+      assert( i < k ); /* cube */
+      assert( j < n ); /* variable */
+      return bill::lit_type( bill::var_type( 2*n*i + 2*j + 1 ), bill::lit_type::polarities::positive );
+    }
+
+    bill::lit_type z( uint32_t l, uint32_t j ) const
+    {
+      assert( l < num_rows ); /* row */
+      assert( j < k ); /* cube */
+      return bill::lit_type( bill::var_type( 2*n*k + k*l + j ), bill::lit_type::polarities::positive );
+    }
+
+    bill::lit_type a( uint32_t i ) const
+    {
+      assert( with_activation );
+      assert( i < k ); /* cube */
+      return bill::lit_type( bill::var_type( 2*n*k + k*num_rows + i ), bill::lit_type::polarities::positive );
+    }
+
+    uint32_t n;
+    uint32_t k;
+    uint32_t num_rows;
+    bool with_activation;
+  };
+
+  template<typename Solver>
+  void add_constraints( Solver& solver, cover_encoding const& enc, std::vector<row_type> const& rows ) const
+  {
+    uint32_t const n = enc.n;
+    uint32_t const k = enc.k;
+
+    /* register 2*n*k p(i,j) and q(i,j) variables, additional k*num_rows auxiliary variables z(l,j), and the activation variables */
+    solver.add_variables( enc.num_variables() );
+
+    for ( auto l = 0u; l < enc.num_rows; ++l ) /* for each row in the divisors */
+    {
+      uint64_t const signature = rows[l].first;
+
+      /* positive */
+      for ( auto i = 0u; i < k; ++i ) /* for each ESOP cube */
+      {
+        for ( auto j = 0u; j < n; ++j ) /* for each variable */
         {
-          clause.push_back( z( l, i ) );
+          std::vector<bill::lit_type> clause = { ~enc.z( l, i ) };
+          clause.push_back( ( ( signature >> j ) & 1u ) ? ~enc.q( i, j ) : ~enc.p( i, j ) );
+          solver.add_clause( clause );
         }
-        bill::add_xor_clause( solver, clause, bill::lit_type::polarities( !kitty::get_bit( target, l ) ) );
       }
 
-      /* at most one cube is allowed to be empty */
-      for ( auto i = 0u; i < k-1; ++i ) // for each ESOP cube
+      /* negative: only active cubes are forced to cover the row */
+      for ( auto i = 0u; i < k; ++i ) /* for each ESOP cube */
       {
-        std::vector<bill::lit_type> clause;
+        std::vector<bill::lit_type> clause = { enc.z( l, i ) };
         for ( auto j = 0u; j < n; ++j ) /* for each variable */
         {
-          clause.push_back( bill::add_tseytin_xor( solver, p( i, j ), q( i, j ) ) );
+          clause.push_back( ( ( signature >> j ) & 1u ) ? enc.q( i, j ) : enc.p( i, j ) );
+        }
+        if ( enc.with_activation )
+        {
+          clause.push_back( ~enc.a( i ) );
+          solver.add_clause( std::vector<bill::lit_type>{ enc.a( i ), ~enc.z( l, i ) } );
         }
         solver.add_clause( clause );
       }
 
-      switch ( solver.solve( {}, ps.num_conflicts ) )
+      /* consider target function */
+      std::vector<bill::lit_type> clause;
+      for ( auto i = 0u; i < k; ++i ) /* for each ESOP cube */
       {
-      case bill::result::states::satisfiable:
+        clause.push_back( enc.z( l, i ) );
+      }
+      bill::add_xor_clause( solver, clause, bill::lit_type::polarities( !rows[l].second ) );
+    }
+
+    /* at most one cube is allowed to be empty: if cube i+1 is active, cube i is not empty */
+    for ( auto i = 0u; i < k-1; ++i ) // for each ESOP cube
+    {
+      std::vector<bill::lit_type> clause;
+      for ( auto j = 0u; j < n; ++j ) /* for each variable */
+      {
+        clause.push_back( bill::add_tseytin_xor( solver, enc.p( i, j ), enc.q( i, j ) ) );
+      }
+      if ( enc.with_activation )
+      {
+        clause.push_back( ~enc.a( i + 1 ) );
+      }
+      solver.add_clause( clause );
+    }
+
+    /* cubes are interchangeable: order all active cubes but the last one lexicographically */
+    if ( ps.break_symmetries )
+    {
+      for ( auto i = 0u; i + 2u < k; ++i )
+      {
+        add_lexicographic_order( solver, enc, i, enc.with_activation ? std::optional<bill::lit_type>( enc.a( i + 2u ) ) : std::nullopt );
+      }
+    }
+  }
+
+  /*! \brief Constrains cube i to be lexicographically smaller than or equal to cube i+1
+
+    The cubes are compared as bit-strings p(i,0) q(i,0) p(i,1) q(i,1) ...
+    Variable e(t) is implied if the first t bits of both cubes are equal.
+    The constraint only applies if `guard` is true.
+  */
+  template<typename Solver>
+  void add_lexicographic_order( Solver& solver, cover_encoding const& enc, uint32_t i, std::optional<bill::lit_type> guard ) const
+  {
+    auto const bit = [&]( uint32_t cube, uint32_t t ) {
+      return ( t & 1u ) ? enc.q( cube, t >> 1u ) : enc.p( cube, t >> 1u );
+    };
+
+    std::optional<bill::lit_type> equal = guard;
+    for ( auto t = 0u; t < 2u * enc.n; ++t )
+    {
+      auto const x = bit( i, t );
+      auto const y = bit( i + 1u, t );
+
+      std::vector<bill::lit_type> clause;
+      if ( equal )
+      {
+        clause.push_back( ~*equal );
+      }
+
+      /* e(t) -> x <= y */
+      auto leq = clause;
+      leq.push_back( ~x );
+      leq.push_back( y );
+      solver.add_clause( leq );
+
+      if ( t + 1u == 2u * enc.n )
+      {
+        break;
+      }
+
+      /* e(t) and x == y -> e(t+1) */
+      bill::lit_type const next( solver.add_variable(), bill::lit_type::polarities::positive );
+      auto both_zero = clause;
+      both_zero.push_back( x );
+      both_zero.push_back( y );
+      both_zero.push_back( next );
+      solver.add_clause( both_zero );
+
+      auto both_one = clause;
+      both_one.push_back( ~x );
+      both_one.push_back( ~y );
+      both_one.push_back( next );
+      solver.add_clause( both_one );
+
+      equal = next;
+    }
+  }
+
+  /*! \brief Solves for k cubes and tries to minimize the number of literals
+
+    Returns false if no k-term cover has been found.  Otherwise,
+    `num_cubes` is set to the size of the smallest cover found.
+  */
+  template<typename Solver>
+  bool solve_and_minimize( Solver& solver, cover_encoding const& enc, uint32_t k, std::vector<bill::lit_type> const& assumptions,
+                           compute_esop_cover_from_divisors_result_type& result, uint32_t& best_cost, uint32_t& num_cubes )
+  {
+    uint32_t const n = enc.n;
+
+    if ( is_out_of_time() )
+    {
+      return false;
+    }
+
+    ++st.num_sat_calls;
+    switch ( solver.solve( assumptions, ps.num_conflicts ) )
+    {
+    case bill::result::states::satisfiable:
+      {
+        auto const model = solver.get_model().model();
+        auto cover = esop_cover_from_model( model, n, k );
+        num_cubes = cover.size();
+        auto const cost = cnot_cost( cover );
+        if ( cost < best_cost )
         {
-          auto const model = solver.get_model().model();
-          auto cover = esop_cover_from_model( model, n, k );
-          auto const cost = cnot_cost( cover );
-          if ( cost < best_cost )
-          {
-            best_cost = cost;
-            result.esop_cover = cover;
-          }
-          // print_cover( cover, n, cost, best_cost );
+          best_cost = cost;
+          result.esop_cover = cover;
+        }
+        // print_cover( cover, n, cost, best_cost );
 
-          /* try to minimize literals */
-          std::vector<bill::lit_type> lits;
-          for ( auto i = 0u; i < k; ++i ) /* for each ESOP cube */
+        /* try to minimize literals */
+        std::vector<bill::lit_type> lits;
+        for ( auto i = 0u; i < k; ++i ) /* for each ESOP cube */
+        {
+          for ( auto j = 0u; j < n; ++j ) /* for each variable */
           {
-            for ( auto j = 0u; j < n; ++j ) /* for each variable */
-            {
-              auto const p_value = model[2*n*i + 2*j] == bill::lbool_type::true_;
-              auto const q_value = model[2*n*i + 2*j + 1] == bill::lbool_type::true_;
+            auto const p_value = model[2*n*i + 2*j] == bill::lbool_type::true_;
+            auto const q_value = model[2*n*i + 2*j + 1] == bill::lbool_type::true_;
 
-              if ( p_value ^ q_value )
+            if ( p_value ^ q_value )
+            {
+              if ( p_value )
+              {
+                lits.push_back( enc.p( i, j ) );
+              }
+              else if ( q_value )
               {
-                if ( p_value )
-                {
-                  lits.push_back( p( i, j ) );
-                }
-                else if ( q_value )
-                {
-                  lits.push_back( q( i, j ) );
-                }
+                lits.push_back( enc.q( i, j ) );
               }
             }
           }
+        }
 
-          std::reverse( std::begin( lits ), std::end( lits ) );
+        std::reverse( std::begin( lits ), std::end( lits ) );
 
-          for ( auto const& l : lits )
+        std::vector<bill::lit_type> lit_assumptions( assumptions );
+        for ( auto const& l : lits )
+        {
+          if ( is_out_of_time() )
           {
-            if ( solver.solve( { ~l }, ps.num_conflicts ) == bill::result::states::satisfiable )
-            {
-              auto const model = solver.get_model().model();
+            break;
+          }
 
-              auto cover = esop_cover_from_model( model, n, k );
-              auto const cost = cnot_cost( cover );
-              if ( cost < best_cost )
-              {
-                best_cost = cost;
-                result.esop_cover = cover;
-              }
-              // print_cover( cover, n, cost, best_cost );
+          lit_assumptions.push_back( ~l );
+          ++st.num_sat_calls;
+          auto const state = solver.solve( lit_assumptions, ps.num_conflicts );
+          lit_assumptions.pop_back();
+          if ( state == bill::result::states::satisfiable )
+          {
+            auto const model = solver.get_model().model();
+
+            auto cover = esop_cover_from_model( model, n, k );
+            num_cubes = std::min<uint32_t>( num_cubes, cover.size() );
+            auto const cost = cnot_cost( cover );
+            if ( cost < best_cost )
+            {
+              best_cost = cost;
+              result.esop_cover = cover;
             }
+            // print_cover( cover, n, cost, best_cost );
           }
-
-          continue;
         }
-        break;
-      case bill::result::states::unsatisfiable:
-      case bill::result::states::undefined:
-        return result;
-      default:
-        std::abort();
       }
+      return true;
+    case bill::result::states::unsatisfiable:
+    case bill::result::states::undefined:
+      return false;
+    default:
+      std::abort();
     }
-    return result;
   }
 
-private:
   void print_cover( std::vector<easy::cube> const& esop, uint32_t num_vars, uint32_t cost, uint32_t best_cost ) const
   {
     for ( const auto& cube : esop )
@@ -497,9 +968,21 @@ private:
     return std::make_pair(true, cost);
   }
 
+  /* checks the time limit and records if it ran out */
+  bool is_out_of_time() const
+  {
+    if ( std::chrono::steady_clock::now() < deadline )
+    {
+      return false;
+    }
+    st.timed_out = true;
+    return true;
+  }
+
 private:
   compute_esop_cover_from_divisors_parameters const ps;
   compute_esop_cover_from_divisors_statistics& st;
+  std::chrono::steady_clock::time_point const deadline;
 };
 
 inline compute_esop_cover_from_divisors_result_type compute_exact_esop_cover_from_divisors( kitty::partial_truth_table const& target, std::vector<kitty::partial_truth_table> const& divisor_functions,
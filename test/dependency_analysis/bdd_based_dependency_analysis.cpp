@@ -0,0 +1,75 @@
+#include <catch.hpp>
+
+#include <angel/dependency_analysis/bdd_based_dependency_analysis.hpp>
+#include <angel/dependency_analysis/common.hpp>
+#include <angel/dependency_analysis/pattern_based_dependency_analysis.hpp>
+
+#include <cplusplus/cuddObj.hh>
+#include <kitty/kitty.hpp>
+
+#include <random>
+
+TEST_CASE( "extract dependencies using BDD based dependency analysis" , "[bdd_based_dependency_analysis]" )
+{
+  kitty::dynamic_truth_table tt{6u};
+  kitty::create_from_hex_string( tt, "0408020110202010" ); /* x0 = x3 ^ x4, x1 = x4 & x5, x2 = ~x5 */
+
+  angel::pattern_deps_analysis_params pattern_ps;
+  pattern_ps.verbose = false;
+  angel::pattern_deps_analysis_stats pattern_st;
+  auto const expected = angel::compute_dependencies<angel::pattern_deps_analysis>( tt, pattern_ps, pattern_st );
+
+  angel::bdd_deps_analysis_params ps;
+  angel::bdd_deps_analysis_stats st;
+  auto const result = angel::compute_dependencies<angel::bdd_deps_analysis>( tt, ps, st );
+
+  CHECK( result.dependencies.size() == 3u );
+  CHECK( result.dependencies == expected.dependencies );
+}
+
+TEST_CASE( "BDD based dependency analysis finds the same patterns" , "[bdd_based_dependency_analysis]" )
+{
+  /* functions with few minterms have many dependencies */
+  for ( auto seed = 0u; seed < 50u; ++seed )
+  {
+    kitty::dynamic_truth_table tt{7u};
+    std::default_random_engine gen( seed );
+    for ( auto k = 0u; k < 6u; ++k )
+    {
+      kitty::set_bit( tt, std::uniform_int_distribution<uint64_t>( 0u, tt.num_bits() - 1u )( gen ) );
+    }
+
+    angel::pattern_deps_analysis_params pattern_ps;
+    pattern_ps.verbose = false;
+    angel::pattern_deps_analysis_stats pattern_st;
+    auto const expected = angel::compute_dependencies<angel::pattern_deps_analysis>( tt, pattern_ps, pattern_st );
+
+    angel::bdd_deps_analysis_params ps;
+    angel::bdd_deps_analysis_stats st;
+    auto const result = angel::compute_dependencies<angel::bdd_deps_analysis>( tt, ps, st );
+
+    CHECK( result.dependencies == expected.dependencies );
+  }
+}
+
+TEST_CASE( "BDD based dependency analysis beyond truth table size" , "[bdd_based_dependency_analysis]" )
+{
+  Cudd cudd;
+  std::vector<BDD> x;
+  for ( auto i = 0; i < 40; ++i )
+  {
+    x.emplace_back( cudd.bddVar( i ) );
+  }
+
+  /* x0 = x10 ^ x39, x1 = x20 & ~x30 */
+  BDD const onset = x[0].Xnor( x[10] ^ x[39] ) & x[1].Xnor( x[20] & !x[30] );
+
+  angel::bdd_deps_analysis_params ps;
+  angel::bdd_deps_analysis_stats st;
+  auto const result = angel::bdd_deps_analysis( ps, st ).run( cudd, onset, 40u );
+
+  CHECK( result.dependencies.size() == 2u );
+  CHECK( result.dependencies.at( 0u ) == angel::dependency_analysis_types::pattern{angel::dependency_analysis_types::pattern_kind::XOR, {20u, 78u}} );
+  CHECK( result.dependencies.at( 1u ) == angel::dependency_analysis_types::pattern{angel::dependency_analysis_types::pattern_kind::AND, {40u, 61u}} );
+  CHECK( st.num_determined_targets == 2u );
+}
@@ -0,0 +1,48 @@
+#include <catch.hpp>
+
+#include <angel/dependency_analysis/cascade_dependency_analysis.hpp>
+#include <angel/dependency_analysis/common.hpp>
+#include <angel/dependency_analysis/esop_based_dependency_analysis.hpp>
+
+#include <kitty/kitty.hpp>
+
+TEST_CASE( "cascade keeps cheap patterns" , "[cascade_dependency_analysis]" )
+{
+  kitty::dynamic_truth_table tt{4u};
+  kitty::create_from_binary_string( tt, "1000000000000001" );
+
+  angel::cascade_deps_analysis_params ps;
+  angel::cascade_deps_analysis_stats st;
+  auto const result = angel::compute_dependencies<angel::cascade_deps_analysis>( tt, ps, st );
+
+  CHECK( result.dependencies.size() == 3u );
+  CHECK( result.dependencies.at( 0 ) == std::vector<std::vector<uint32_t>>{{2u}} );
+  CHECK( result.dependencies.at( 1 ) == std::vector<std::vector<uint32_t>>{{4u}} );
+  CHECK( result.dependencies.at( 2 ) == std::vector<std::vector<uint32_t>>{{6u}} );
+  CHECK( st.num_pattern_dependencies == 3u );
+  CHECK( st.num_esop_dependencies == 0u );
+}
+
+TEST_CASE( "cascade passes remaining targets to ESOP synthesis" , "[cascade_dependency_analysis]" )
+{
+  /* on-set: x0 = x1 x2 XOR x3 */
+  kitty::dynamic_truth_table tt{4u}, x0{4u}, x1{4u}, x2{4u}, x3{4u};
+  kitty::create_nth_var( x0, 0 );
+  kitty::create_nth_var( x1, 1 );
+  kitty::create_nth_var( x2, 2 );
+  kitty::create_nth_var( x3, 3 );
+  tt = ~( x0 ^ ( ( x1 & x2 ) ^ x3 ) );
+
+  angel::cascade_deps_analysis_params ps;
+  angel::cascade_deps_analysis_stats st;
+  auto const result = angel::compute_dependencies<angel::cascade_deps_analysis>( tt, ps, st );
+
+  angel::esop_deps_analysis_params esop_ps;
+  angel::esop_deps_analysis_stats esop_st;
+  auto const esop_result = angel::compute_dependencies<angel::esop_deps_analysis>( tt, esop_ps, esop_st );
+
+  CHECK( st.num_esop_targets > 0u );
+  REQUIRE( result.dependencies.count( 0u ) == 1u );
+  REQUIRE( esop_result.dependencies.count( 0u ) == 1u );
+  CHECK( angel::esop_gate_cost( result.dependencies.at( 0u ) ).first == angel::esop_gate_cost( esop_result.dependencies.at( 0u ) ).first );
+}
@@ -6,7 +6,9 @@
 #include <kitty/kitty.hpp>
 
 #include <fmt/format.h>
+#include <algorithm>
 #include <iostream>
+#include <random>
 
 TEST_CASE( "extract dependencies as ESOP cover" , "[esop_based_dependency_analysis]" )
 {
@@ -40,3 +42,120 @@ TEST_CASE( "extract dependencies as ESOP cover" , "[esop_based_dependency_analys
     }
   }
 }
+
+TEST_CASE( "heuristic ESOP cover before exact synthesis" , "[esop_based_dependency_analysis]" )
+{
+  /* on-set: x0 = x1 XOR x2 */
+  kitty::dynamic_truth_table tt{3u};
+  kitty::create_from_binary_string( tt, "01101001" );
+
+  angel::esop_deps_analysis_params ps;
+  angel::esop_deps_analysis_stats st;
+  auto const result = angel::compute_dependencies<angel::esop_deps_analysis>( tt, ps, st );
+
+  /* the PPRM cover meets the lower bound and no exact synthesis is needed */
+  REQUIRE( result.dependencies.count( 0u ) == 1u );
+  auto cover = result.dependencies.at( 0u );
+  std::sort( std::begin( cover ), std::end( cover ) );
+  CHECK( cover == std::vector<std::vector<uint32_t>>{{2u}, {4u}} );
+  CHECK( st.num_heuristic_covers > 0u );
+
+  angel::esop_deps_analysis_params exact_ps;
+  exact_ps.use_heuristic = false;
+  angel::esop_deps_analysis_stats exact_st;
+  auto const exact_result = angel::compute_dependencies<angel::esop_deps_analysis>( tt, exact_ps, exact_st );
+  REQUIRE( exact_result.dependencies.count( 0u ) == 1u );
+  CHECK( angel::esop_gate_cost( exact_result.dependencies.at( 0u ) ).first == angel::esop_gate_cost( result.dependencies.at( 0u ) ).first );
+  CHECK( exact_st.num_heuristic_covers == 0u );
+}
+
+TEST_CASE( "reuse ESOP covers of identical covering problems" , "[esop_based_dependency_analysis]" )
+{
+  kitty::dynamic_truth_table tt{4u};
+  kitty::create_from_hex_string( tt, "9669" );
+
+  angel::esop_deps_analysis_params ps;
+  angel::esop_deps_analysis_stats st;
+  angel::esop_deps_analysis analysis( ps, st );
+
+  auto const first = analysis.run( tt );
+  auto const num_lookups = st.num_cache_hits + st.num_cache_misses;
+  auto const num_misses = st.num_cache_misses;
+  CHECK( num_misses > 0u );
+
+  /* all problems are found in the cache */
+  auto const second = analysis.run( tt );
+  CHECK( st.num_cache_misses == num_misses );
+  CHECK( st.num_cache_hits + st.num_cache_misses == 2u * num_lookups );
+  CHECK( first.dependencies == second.dependencies );
+
+  angel::esop_deps_analysis_params uncached_ps;
+  uncached_ps.use_cache = false;
+  angel::esop_deps_analysis_stats uncached_st;
+  auto const uncached = angel::esop_deps_analysis( uncached_ps, uncached_st ).run( tt );
+  CHECK( uncached_st.num_cache_misses == 0u );
+  CHECK( first.dependencies == uncached.dependencies );
+}
+
+TEST_CASE( "distinguishing power matrix of the columns" , "[esop_based_dependency_analysis]" )
+{
+  kitty::dynamic_truth_table tt{6u};
+  kitty::create_from_hex_string( tt, "0408020110e02a10" );
+
+  auto const columns = angel::create_columns( angel::compute_column_matrix( tt ) );
+  auto const power = angel::detail::compute_distinguishing_power_matrix( columns );
+  for ( auto i = 0u; i < columns.size(); ++i )
+  {
+    for ( auto j = 0u; j < columns.size(); ++j )
+    {
+      if ( i != j )
+      {
+        CHECK( power[i * columns.size() + j] == kitty::relative_distinguishing_power( columns[j].tt, columns[i].tt ) );
+      }
+    }
+  }
+}
+
+TEST_CASE( "ESOP based dependency analysis with time budgets" , "[esop_based_dependency_analysis]" )
+{
+  /* every dependency of this function needs exact synthesis, which takes much longer than 1ms */
+  kitty::dynamic_truth_table tt{14u};
+  std::default_random_engine gen( 2u );
+  for ( auto k = 0u; k < 32u; ++k )
+  {
+    kitty::set_bit( tt, std::uniform_int_distribution<uint64_t>( 0u, tt.num_bits() - 1u )( gen ) );
+  }
+
+  angel::esop_deps_analysis_params ps;
+  ps.use_cache = false;
+  angel::esop_deps_analysis_stats st;
+  auto const result = angel::compute_dependencies<angel::esop_deps_analysis>( tt, ps, st );
+  CHECK( st.num_target_timeouts == 0u );
+  CHECK( st.num_function_timeouts == 0u );
+  CHECK( st.num_exact_syntheses > 0u );
+
+  /* the budgets depend on the speed of the machine, so only check what holds for any timing */
+  angel::esop_deps_analysis_params target_ps = ps;
+  target_ps.target_time_limit = 1u;
+  angel::esop_deps_analysis_stats target_st;
+  auto const target_result = angel::compute_dependencies<angel::esop_deps_analysis>( tt, target_ps, target_st );
+  CHECK( target_st.num_function_timeouts == 0u );
+  CHECK( target_st.num_skipped_targets == 0u );
+  CHECK( target_result.dependencies.size() <= result.dependencies.size() );
+  if ( target_result.dependencies.size() < result.dependencies.size() )
+  {
+    CHECK( target_st.num_target_timeouts > 0u );
+  }
+
+  angel::esop_deps_analysis_params function_ps = ps;
+  function_ps.function_time_limit = 1u;
+  angel::esop_deps_analysis_stats function_st;
+  auto const function_result = angel::compute_dependencies<angel::esop_deps_analysis>( tt, function_ps, function_st );
+  CHECK( function_st.num_function_timeouts <= 1u );
+  CHECK( ( function_st.num_function_timeouts == 1u ) == ( function_st.num_skipped_targets > 0u ) );
+  CHECK( function_result.dependencies.size() <= result.dependencies.size() );
+  if ( function_result.dependencies.size() < result.dependencies.size() )
+  {
+    CHECK( function_st.num_function_timeouts + function_st.num_target_timeouts > 0u );
+  }
+}
@@ -5,6 +5,7 @@
 #include <kitty/kitty.hpp>
 #include <fmt/format.h>
 #include <iostream>
+#include <random>
 
 TEST_CASE( "extract dependencies using pattern based dependency analysis" , "[pattern_based_dependency_analysis]" )
 {
@@ -25,3 +26,113 @@ TEST_CASE( "extract dependencies using pattern based dependency analysis" , "[pa
     
   }
 }
+
+TEST_CASE( "extract AND dependency with complemented fanin" , "[pattern_based_dependency_analysis]" )
+{
+  kitty::dynamic_truth_table tt{3u};
+  kitty::create_from_binary_string(tt, "01011001"); /* x0 = x1 & ~x2 */
+
+  angel::pattern_deps_analysis_params ps;
+  angel::pattern_deps_analysis_stats st;
+  auto const result = angel::compute_dependencies<angel::pattern_deps_analysis>( tt, ps, st );
+
+  CHECK( result.dependencies.size() == 1u );
+  CHECK( result.dependencies.at( 0u ).first == angel::dependency_analysis_types::pattern_kind::AND );
+  CHECK( result.dependencies.at( 0u ).second == std::vector<uint32_t>{2u, 5u} );
+}
+
+TEST_CASE( "pattern based dependency analysis with multiple threads" , "[pattern_based_dependency_analysis]" )
+{
+  kitty::dynamic_truth_table tt{6u};
+  kitty::create_from_hex_string( tt, "0408020110202010" ); /* x0 = x3 ^ x4, x1 = x4 & x5, x2 = ~x5 */
+
+  angel::pattern_deps_analysis_params ps;
+  angel::pattern_deps_analysis_stats st;
+  auto const expected = angel::compute_dependencies<angel::pattern_deps_analysis>( tt, ps, st );
+
+  ps.num_threads = 4u;
+  angel::pattern_deps_analysis_stats st_threads;
+  auto const result = angel::compute_dependencies<angel::pattern_deps_analysis>( tt, ps, st_threads );
+
+  CHECK( expected.dependencies.size() == 3u );
+  CHECK( result.dependencies == expected.dependencies );
+  CHECK( st_threads.num_patterns == st.num_patterns );
+  CHECK( st_threads.num_2tuples == st.num_2tuples );
+}
+
+TEST_CASE( "pattern based dependency analysis for some targets only" , "[pattern_based_dependency_analysis]" )
+{
+  kitty::dynamic_truth_table tt{6u};
+  kitty::create_from_hex_string( tt, "0408020110202010" ); /* x0 = x3 ^ x4, x1 = x4 & x5, x2 = ~x5 */
+
+  angel::pattern_deps_analysis_params ps;
+  angel::pattern_deps_analysis_stats st;
+  angel::pattern_deps_analysis analysis( ps, st );
+  auto const columns = angel::compute_column_matrix( tt );
+  auto const expected = analysis.run( tt, columns );
+
+  for ( auto i = 0u; i < 6u; ++i )
+  {
+    auto const result = analysis.run( tt, columns, std::vector<uint32_t>{i} );
+    CHECK( result.dependencies.size() == expected.dependencies.count( i ) );
+    if ( expected.dependencies.count( i ) )
+    {
+      CHECK( result.dependencies.at( i ) == expected.dependencies.at( i ) );
+    }
+  }
+}
+
+TEST_CASE( "pattern based dependency analysis with and without upper bound" , "[pattern_based_dependency_analysis]" )
+{
+  using pattern_kind = angel::dependency_analysis_types::pattern_kind;
+
+  for ( auto seed = 0u; seed < 50u; ++seed )
+  {
+    kitty::dynamic_truth_table tt{6u};
+    std::default_random_engine gen( seed );
+    for ( auto k = 0u; k < 6u; ++k )
+    {
+      kitty::set_bit( tt, std::uniform_int_distribution<uint64_t>( 0u, tt.num_bits() - 1u )( gen ) );
+    }
+
+    angel::pattern_deps_analysis_params ps;
+    ps.verbose = false;
+    CHECK( !ps.use_upperbound );
+    angel::pattern_deps_analysis_stats st;
+    auto const unbounded = angel::compute_dependencies<angel::pattern_deps_analysis>( tt, ps, st );
+
+    ps.use_upperbound = true;
+    angel::pattern_deps_analysis_stats bounded_st;
+    auto const bounded = angel::compute_dependencies<angel::pattern_deps_analysis>( tt, ps, bounded_st );
+
+    /* the bound only drops the patterns that cost more CNOTs than the target without dependencies */
+    auto const columns = angel::compute_column_matrix( tt );
+    std::vector<uint32_t> zero_lines, one_lines;
+    for ( auto i = 0u; i < columns.size(); ++i )
+    {
+      if ( kitty::is_const0( columns[i] ) )
+      {
+        zero_lines.emplace_back( i );
+      }
+      else if ( kitty::is_const0( ~columns[i] ) )
+      {
+        one_lines.emplace_back( i );
+      }
+    }
+
+    for ( auto const& [target, pattern] : unbounded.dependencies )
+    {
+      auto const it = bounded.dependencies.find( target );
+      if ( pattern.first == pattern_kind::CONST || angel::pattern_cost( pattern ).first <= angel::compute_upperbound_cost( zero_lines, one_lines, 6u, target ) )
+      {
+        REQUIRE( it != bounded.dependencies.end() );
+        CHECK( it->second == pattern );
+      }
+      else
+      {
+        CHECK( it == bounded.dependencies.end() );
+      }
+    }
+    CHECK( bounded.dependencies.size() <= unbounded.dependencies.size() );
+  }
+}
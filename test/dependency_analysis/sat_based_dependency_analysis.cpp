@@ -0,0 +1,127 @@
+#include <catch.hpp>
+
+#include <angel/dependency_analysis/common.hpp>
+#include <angel/dependency_analysis/pattern_based_dependency_analysis.hpp>
+#include <angel/dependency_analysis/sat_based_dependency_analysis.hpp>
+
+#include <kitty/kitty.hpp>
+#include <mockturtle/networks/aig.hpp>
+
+#include <random>
+
+TEST_CASE( "extract dependencies using SAT based dependency analysis" , "[sat_based_dependency_analysis]" )
+{
+  kitty::dynamic_truth_table tt{6u};
+  kitty::create_from_hex_string( tt, "0408020110202010" ); /* x0 = x3 ^ x4, x1 = x4 & x5, x2 = ~x5 */
+
+  angel::pattern_deps_analysis_params pattern_ps;
+  pattern_ps.verbose = false;
+  angel::pattern_deps_analysis_stats pattern_st;
+  auto const expected = angel::compute_dependencies<angel::pattern_deps_analysis>( tt, pattern_ps, pattern_st );
+
+  angel::sat_deps_analysis_params ps;
+  angel::sat_deps_analysis_stats st;
+  auto const result = angel::compute_dependencies<angel::sat_deps_analysis>( tt, ps, st );
+
+  CHECK( result.dependencies.size() == 3u );
+  CHECK( result.dependencies == expected.dependencies );
+}
+
+TEST_CASE( "SAT based dependency analysis finds valid patterns" , "[sat_based_dependency_analysis]" )
+{
+  for ( auto seed = 0u; seed < 50u; ++seed )
+  {
+    kitty::dynamic_truth_table tt{7u};
+    std::default_random_engine gen( seed );
+    for ( auto k = 0u; k < 6u; ++k )
+    {
+      kitty::set_bit( tt, std::uniform_int_distribution<uint64_t>( 0u, tt.num_bits() - 1u )( gen ) );
+    }
+
+    angel::sat_deps_analysis_params ps;
+    angel::sat_deps_analysis_stats st;
+    auto const result = angel::compute_dependencies<angel::sat_deps_analysis>( tt, ps, st );
+
+    /* every pattern holds on all minterms of the on-set */
+    kitty::for_each_one_bit( tt, [&]( auto minterm ) {
+      for ( auto const& [i, p] : result.dependencies )
+      {
+        auto const value = [&]( uint32_t lit ) { return ( ( minterm >> ( lit / 2u ) ) & 1u ) != ( lit % 2u ); };
+        bool target;
+        switch ( p.first )
+        {
+        case angel::dependency_analysis_types::pattern_kind::CONST:
+          target = p.second[0u] == 1u;
+          break;
+        case angel::dependency_analysis_types::pattern_kind::EQUAL:
+          target = value( p.second[0u] );
+          break;
+        case angel::dependency_analysis_types::pattern_kind::XOR:
+        case angel::dependency_analysis_types::pattern_kind::XNOR:
+          target = p.first == angel::dependency_analysis_types::pattern_kind::XNOR;
+          for ( auto const lit : p.second )
+          {
+            target ^= value( lit );
+          }
+          break;
+        default:
+          target = true;
+          for ( auto const lit : p.second )
+          {
+            target = target && value( lit );
+          }
+          if ( p.first == angel::dependency_analysis_types::pattern_kind::NAND )
+          {
+            target = !target;
+          }
+          break;
+        }
+        CHECK( ( ( minterm >> i ) & 1u ) == target );
+      }
+    } );
+  }
+}
+
+TEST_CASE( "SAT based dependency analysis on an AIG" , "[sat_based_dependency_analysis]" )
+{
+  mockturtle::aig_network aig;
+  std::vector<mockturtle::aig_network::signal> x;
+  for ( auto i = 0u; i < 40u; ++i )
+  {
+    x.emplace_back( aig.create_pi() );
+  }
+
+  /* x0 = x10 ^ x39, x1 = x20 & ~x30 */
+  aig.create_po( aig.create_and( aig.create_xnor( x[0], aig.create_xor( x[10], x[39] ) ),
+                                 aig.create_xnor( x[1], aig.create_and( x[20], !x[30] ) ) ) );
+
+  angel::sat_deps_analysis_params ps;
+  angel::sat_deps_analysis_stats st;
+  auto const result = angel::sat_deps_analysis( ps, st ).run( aig );
+
+  CHECK( result.dependencies.size() == 2u );
+  CHECK( result.dependencies.at( 0u ) == angel::dependency_analysis_types::pattern{angel::dependency_analysis_types::pattern_kind::XOR, {20u, 78u}} );
+  CHECK( result.dependencies.at( 1u ) == angel::dependency_analysis_types::pattern{angel::dependency_analysis_types::pattern_kind::AND, {40u, 61u}} );
+  CHECK( st.num_defined_targets == 2u );
+}
+
+TEST_CASE( "SAT based dependency analysis compares several defining sets" , "[sat_based_dependency_analysis]" )
+{
+  /* x0 = x1 ^ x2 ^ x3 and x4 = x1 ^ x2 ^ x3, so x0 is defined by { x1, x2, x3 } and by { x4 }, and x1 by { x2, x3, x4 } */
+  kitty::dynamic_truth_table tt{5u};
+  for ( auto m = 0u; m < 8u; ++m )
+  {
+    uint32_t const parity = __builtin_popcount( m ) & 1u;
+    kitty::set_bit( tt, parity | ( m << 1u ) | ( parity << 4u ) );
+  }
+
+  angel::sat_deps_analysis_params ps;
+  ps.max_defining_sets = 2u;
+  angel::sat_deps_analysis_stats st;
+  auto const result = angel::compute_dependencies<angel::sat_deps_analysis>( tt, ps, st );
+
+  CHECK( result.dependencies.size() == 2u );
+  CHECK( result.dependencies.at( 0u ) == angel::dependency_analysis_types::pattern{angel::dependency_analysis_types::pattern_kind::EQUAL, {8u}} );
+  CHECK( result.dependencies.at( 1u ) == angel::dependency_analysis_types::pattern{angel::dependency_analysis_types::pattern_kind::XOR, {4u, 6u, 8u}} );
+  CHECK( st.num_defined_targets == 2u );
+}
@@ -0,0 +1,115 @@
+#include <catch.hpp>
+
+#include <angel/quantum_state_preparation/qsp_bdd.hpp>
+#include <tweedledum/gates/mcmt_gate.hpp>
+#include <tweedledum/networks/netlist.hpp>
+#include <kitty/kitty.hpp>
+
+TEST_CASE( "Create BDDs from truth tables", "[qsp_bdd]" )
+{
+  for ( auto num_vars = 1u; num_vars <= 9u; ++num_vars )
+  {
+    kitty::dynamic_truth_table tt( num_vars );
+    for ( auto seed = 0u; seed < 20u; ++seed )
+    {
+      kitty::create_random( tt, seed );
+
+      Cudd cudd;
+      auto const f = angel::detail::create_bdd_from_tt( cudd, tt );
+      CHECK( cudd.ReadSize() == static_cast<int>( num_vars ) );
+
+      /* variable `i` of the truth table is BDD variable `num_vars - 1 - i` */
+      std::vector<int> inputs( num_vars );
+      for ( auto m = 0u; m < tt.num_bits(); ++m )
+      {
+        for ( auto i = 0u; i < num_vars; ++i )
+        {
+          inputs[num_vars - 1u - i] = ( m >> i ) & 1u;
+        }
+        CHECK( f.Eval( inputs.data() ).IsOne() == kitty::get_bit( tt, m ) );
+      }
+    }
+  }
+}
+
+TEST_CASE( "Prepare GHZ(3) state with qsp_bdd method", "[qsp_bdd]" )
+{
+  tweedledum::netlist<tweedledum::mcmt_gate> network;
+
+  angel::qsp_bdd_statistics stats;
+  angel::qsp_bdd( network, "10000001", stats );
+
+  CHECK( stats.cnots == 2u );
+  CHECK( stats.sqgs == 1u );
+}
+
+TEST_CASE( "Prepare state with shared BDD nodes with qsp_bdd method", "[qsp_bdd]" )
+{
+  tweedledum::netlist<tweedledum::mcmt_gate> network;
+
+  /* the cofactors x0 & x1 and x0 | x1 of the majority function share the node of x0 */
+  angel::qsp_bdd_statistics stats;
+  angel::qsp_bdd( network, "11101000", stats );
+
+  CHECK( stats.nodes == 4u );
+  CHECK( stats.MC_gates == 5u );
+  CHECK( stats.cnots == 6u );
+  CHECK( stats.sqgs == 7u );
+}
+
+TEST_CASE( "Count ones of BDDs with more than 32 variables", "[qsp_bdd]" )
+{
+  for ( auto const num_vars : {40u, 64u, 70u} )
+  {
+    Cudd cudd;
+    for ( auto i = 0u; i < num_vars; ++i )
+    {
+      cudd.bddVar( i );
+    }
+
+    auto const f = cudd.bddVar( 0 ) & cudd.bddVar( num_vars - 1 );
+    auto const node_ones = angel::detail::count_ones_bdd_nodes( f.getNode(), num_vars );
+    CHECK( node_ones.ones.size() == 2u );
+    CHECK( angel::detail::edge_ones( node_ones, node_ones.root, num_vars, 0u ) == std::ldexp( 1.0, num_vars - 2 ) );
+    CHECK( angel::detail::edge_ones( node_ones, node_ones.root ^ 1u, num_vars, 0u ) == 3 * std::ldexp( 1.0, num_vars - 2 ) );
+    CHECK( angel::detail::edge_ones( node_ones, angel::detail::bdd_node_ones::const1_edge, num_vars, 0u ) == std::ldexp( 1.0, num_vars ) );
+
+    /* the nodes are unmarked after counting */
+    CHECK( Cudd_DagSize( f.getNode() ) == 3 );
+    CHECK( angel::detail::count_ones_bdd_nodes( f.getNode(), num_vars ).ones == node_ones.ones );
+  }
+}
+
+TEST_CASE( "Prepare states of different sizes with one qsp_bdd engine", "[qsp_bdd]" )
+{
+  tweedledum::netlist<tweedledum::mcmt_gate> network;
+
+  angel::qsp_bdd_engine_params ps;
+  ps.batch_size = 3u;
+  ps.dump_bdd = false;
+  angel::qsp_bdd_engine engine( ps );
+
+  for ( auto seed = 0u; seed < 20u; ++seed )
+  {
+    kitty::dynamic_truth_table tt( 2u + ( seed * 5u ) % 7u );
+    kitty::create_random( tt, seed );
+    if ( kitty::is_const0( tt ) )
+    {
+      kitty::set_bit( tt, 0u );
+    }
+    auto const str = kitty::to_binary( tt );
+
+    angel::qsp_bdd_statistics expected, stats;
+    angel::qsp_bdd( network, str, expected );
+    engine( network, str, stats );
+
+    CHECK( stats.nodes == expected.nodes );
+    CHECK( stats.MC_gates == expected.MC_gates );
+    CHECK( stats.cnots == expected.cnots );
+    CHECK( stats.sqgs == expected.sqgs );
+  }
+
+  /* the variables of the largest state are shared by all states */
+  CHECK( engine.manager().ReadSize() == 8 );
+  CHECK( engine.manager().ReadGarbageCollections() > 0 );
+}
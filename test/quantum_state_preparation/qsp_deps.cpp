@@ -0,0 +1,39 @@
+#include <catch.hpp>
+
+#include <angel/dependency_analysis/pattern_based_dependency_analysis.hpp>
+#include <angel/quantum_state_preparation/qsp_deps.hpp>
+#include <angel/reordering/no_reordering.hpp>
+#include <tweedledum/gates/mcmt_gate.hpp>
+#include <tweedledum/networks/netlist.hpp>
+#include <kitty/constructors.hpp>
+
+TEST_CASE( "Dependencies are only computed for the targets reached in gate generation", "[qsp_deps]" )
+{
+  tweedledum::netlist<tweedledum::mcmt_gate> ntk;
+  angel::no_reordering no_reorder;
+
+  angel::pattern_deps_analysis_params pattern_ps;
+  pattern_ps.verbose = false;
+  angel::pattern_deps_analysis_stats pattern_st;
+  angel::pattern_deps_analysis pattern( pattern_ps, pattern_st );
+
+  angel::state_preparation_parameters ps;
+  angel::state_preparation_statistics st;
+  angel::qsp_deps<decltype( ntk ), decltype( pattern ), decltype( no_reorder )> prep( ntk, pattern, no_reorder, ps, st );
+
+  /* GHZ(3): x0 = x2 and x1 = x2, nothing can depend on the last variable */
+  kitty::dynamic_truth_table tt( 3 );
+  kitty::create_from_binary_string( tt, "10000001" );
+  auto const ghz = prep.synthesize_network( tt );
+  CHECK( ghz.cnots_sqgs.first == 2u );
+  CHECK( st.num_analysed_targets == 2u );
+  CHECK( st.num_skipped_targets == 1u );
+
+  /* x2 is constant one and is never passed to the analysis, x1 is only preceded by a constant */
+  st.reset();
+  kitty::create_from_binary_string( tt, "10010000" );
+  auto const constant = prep.synthesize_network( tt );
+  CHECK( constant.cnots_sqgs.first == 1u );
+  CHECK( st.num_analysed_targets == 1u );
+  CHECK( st.num_skipped_targets == 1u );
+}
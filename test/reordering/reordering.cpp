@@ -0,0 +1,39 @@
+#include <catch.hpp>
+
+#include <angel/reordering/exhaustive_reordering.hpp>
+#include <angel/reordering/greedy_reordering.hpp>
+#include <angel/reordering/no_reordering.hpp>
+#include <angel/reordering/random_reordering.hpp>
+
+#include <kitty/kitty.hpp>
+
+TEST_CASE( "Reorderings call callbacks with and without the order", "[reordering]" )
+{
+  kitty::dynamic_truth_table tt{3u};
+  kitty::create_from_hex_string( tt, "e8" );
+
+  uint32_t num_calls = 0u;
+  angel::no_reordering().foreach_reordering( tt, [&]( kitty::dynamic_truth_table const& reordered ) {
+    CHECK( reordered == tt );
+    ++num_calls;
+  } );
+  CHECK( num_calls == 1u );
+
+  std::vector<kitty::dynamic_truth_table> with_order, without_order;
+  angel::exhaustive_reordering().foreach_reordering( tt, [&]( kitty::dynamic_truth_table const& reordered, std::vector<uint32_t> const& order ) {
+    CHECK( order.size() == 3u );
+    with_order.emplace_back( reordered );
+  } );
+  angel::exhaustive_reordering().foreach_reordering( tt, [&]( kitty::dynamic_truth_table const& reordered ) {
+    without_order.emplace_back( reordered );
+  } );
+  CHECK( with_order.size() == 6u );
+  CHECK( with_order == without_order );
+
+  /* the greedy reordering uses the returned cost of both kinds of callbacks */
+  num_calls = 0u;
+  angel::greedy_reordering().foreach_reordering( tt, [&]( kitty::dynamic_truth_table const& ) {
+    return ++num_calls;
+  } );
+  CHECK( num_calls >= 2u );
+}
@@ -0,0 +1,52 @@
+#include <catch.hpp>
+#include <angel/utils/column_matrix.hpp>
+#include <kitty/kitty.hpp>
+
+TEST_CASE( "Compute column vectors of a small function", "[column_matrix]" )
+{
+  kitty::dynamic_truth_table tt( 3u );
+  kitty::create_from_binary_string( tt, "01011001" ); /* minterms 0, 3, 4, 6 */
+
+  auto const columns = angel::compute_column_matrix( tt );
+  CHECK( columns.size() == 3u );
+  CHECK( columns[0u].num_bits() == 4 );
+  CHECK( columns[0u]._bits[0u] == 0x2 );
+  CHECK( columns[1u]._bits[0u] == 0xa );
+  CHECK( columns[2u]._bits[0u] == 0xc );
+}
+
+TEST_CASE( "Compute column vectors of a function with more than 64 minterms", "[column_matrix]" )
+{
+  kitty::dynamic_truth_table tt( 8u );
+  kitty::create_random( tt, 42 );
+
+  auto const columns = angel::compute_column_matrix( tt );
+  auto const minterms = kitty::get_minterms( tt );
+  CHECK( columns.size() == 8u );
+  CHECK( minterms.size() > 64u );
+
+  for ( auto i = 0u; i < columns.size(); ++i )
+  {
+    CHECK( uint32_t( columns[i].num_bits() ) == minterms.size() );
+    for ( auto j = 0u; j < minterms.size(); ++j )
+    {
+      CHECK( kitty::get_bit( columns[i], j ) == ( ( minterms[j] >> i ) & 1u ) );
+    }
+  }
+}
+
+TEST_CASE( "Compute row signatures of columns", "[column_matrix]" )
+{
+  kitty::dynamic_truth_table tt( 7u );
+  kitty::create_random( tt, 7 );
+
+  auto const columns = angel::compute_column_matrix( tt );
+  auto const signatures = angel::compute_row_signatures( columns );
+  auto const minterms = kitty::get_minterms( tt );
+
+  CHECK( signatures.size() == minterms.size() );
+  for ( auto j = 0u; j < minterms.size(); ++j )
+  {
+    CHECK( signatures[j] == minterms[j] );
+  }
+}
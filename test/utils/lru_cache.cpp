@@ -0,0 +1,32 @@
+#include <catch.hpp>
+#include <angel/utils/lru_cache.hpp>
+
+TEST_CASE( "Evict the least recently used entry", "[lru_cache]" )
+{
+  angel::lru_cache<uint32_t, uint32_t> cache( 2u );
+  cache.insert( 1u, 10u );
+  cache.insert( 2u, 20u );
+
+  /* 1 becomes the most recently used entry, so inserting 3 evicts 2 */
+  REQUIRE( cache.find( 1u ) != nullptr );
+  CHECK( *cache.find( 1u ) == 10u );
+  cache.insert( 3u, 30u );
+  CHECK( cache.size() == 2u );
+  CHECK( cache.find( 2u ) == nullptr );
+  CHECK( *cache.find( 1u ) == 10u );
+  CHECK( *cache.find( 3u ) == 30u );
+
+  /* updating an entry does not evict */
+  cache.insert( 1u, 11u );
+  CHECK( cache.size() == 2u );
+  CHECK( *cache.find( 1u ) == 11u );
+  CHECK( *cache.find( 3u ) == 30u );
+}
+
+TEST_CASE( "Cache without capacity keeps nothing", "[lru_cache]" )
+{
+  angel::lru_cache<uint32_t, uint32_t> cache( 0u );
+  cache.insert( 1u, 10u );
+  CHECK( cache.size() == 0u );
+  CHECK( cache.find( 1u ) == nullptr );
+}